@@ -6,6 +6,48 @@
 # for remote debugging.
 #
 # Usage: ./deploy.sh <IP> <DEBUG_PORT> <BINARY> <DEST_DIR> <USER> <PASS>
+#        ./deploy.sh --rollback <IP> <DEBUG_PORT> <BINARY> <DEST_DIR> <USER> <PASS>
+#
+# Every deployed version gets its own directory and DEST_DIR/<BINARY> is a
+# symlink to the active one:
+#
+#   DEST_DIR/<BINARY> -> releases/<BINARY>-<utc time>-<sha256 prefix>/<BINARY>
+#
+# A new version is uploaded next to the running one and activated by renaming
+# a new symlink over the old, which is atomic: the binary is never missing or
+# half-written, and gdbserver is only restarted once the switch is done. The
+# DEPLOY_KEEP previous versions stay on the target; --rollback switches back
+# to the one before the active version without sending anything, and
+# deploying a version that is still kept (and whose copy still has the same
+# sha256) just switches to it again.
+#
+# Only what changed is sent: nothing when the target already has the same
+# binary (sha256), an rsync delta when both sides have rsync, a bsdiff patch
+# against the last binary deployed from this machine when the target has
+# bspatch, and otherwise the compressed binary. The upload is checked against
+# the local sha256 on the target before it is activated.
+#
+# IP may be given as <host>:<port> for sshd on a non-default port. IP
+# "local" deploys into the local directory DEST_DIR instead of over ssh
+# (USER and PASS are ignored), for testing without a board.
+#
+# ./deploy.sh --fleet [options] <inventory> deploys to many targets at once
+# (see scripts/deploy_fleet.sh).
+#
+# All ssh, rsync and gdbserver sessions share one multiplexed connection
+# (ControlMaster): sshpass authenticates once, later sessions open in a round
+# trip, and the master stays up for DEPLOY_CONTROL_PERSIST seconds so the
+# next redeploy skips the handshake as well. Each step is timed.
+#
+# Environment:
+#   DEPLOY_TRANSFER   auto | rsync | bsdiff | full (default: auto)
+#   DEPLOY_COMPRESS   full-transfer compression: gzip | xz | none (default: gzip)
+#   DEPLOY_GDBSERVER  start gdbserver after deploying: 1 | 0 (default: 1)
+#   DEPLOY_CACHE      copies of deployed binaries, the bsdiff base
+#                     (default: build/deploy)
+#   DEPLOY_CONTROL_PERSIST  seconds the shared connection stays open after
+#                     the last session (default: 600; 0 closes it on exit)
+#   DEPLOY_KEEP       previous versions kept for rollback (default: 3)
 # ============================================================================
 
 set -e  # Exit on error
@@ -29,6 +71,18 @@ log_error() {
     echo -e "${RED}[ERROR]${NC} $1"
 }
 
+# Fleet mode: fan out to every target in an inventory
+if [ "$1" = --fleet ]; then
+    shift
+    exec "$(dirname "$0")/scripts/deploy_fleet.sh" "$@"
+fi
+
+ROLLBACK=0
+if [ "$1" = --rollback ]; then
+    ROLLBACK=1
+    shift
+fi
+
 # Parse arguments
 DEST_IP="${1:?Error: TARGET_IP is required}"
 DEBUG_PORT="${2:?Error: DEBUG_PORT is required}"
@@ -37,44 +91,312 @@ DEST_DIR="${4:?Error: DEST_DIR is required}"
 USER="${5:?Error: USER is required}"
 PASS="${6:?Error: PASS is required}"
 
-# Validate binary exists
-if [ ! -f "${BINARY}" ]; then
+DEPLOY_TRANSFER="${DEPLOY_TRANSFER:-auto}"
+DEPLOY_COMPRESS="${DEPLOY_COMPRESS:-gzip}"
+DEPLOY_GDBSERVER="${DEPLOY_GDBSERVER:-1}"
+DEPLOY_CACHE="${DEPLOY_CACHE:-build/deploy}"
+DEPLOY_CONTROL_PERSIST="${DEPLOY_CONTROL_PERSIST:-600}"
+DEPLOY_KEEP="${DEPLOY_KEEP:-3}"
+
+# %C hashes user, host and port, so each target gets its own master
+CONTROL_PATH="${XDG_RUNTIME_DIR:-/tmp}/deploy-ssh-%C"
+SSH_OPTS=(-o StrictHostKeyChecking=no -o ConnectTimeout=10
+          -o ControlMaster=auto -o "ControlPath=${CONTROL_PATH}"
+          -o "ControlPersist=${DEPLOY_CONTROL_PERSIST}")
+SSH_HOST="${DEST_IP%:*}"
+if [ "${SSH_HOST}" != "${DEST_IP}" ]; then
+    SSH_OPTS+=(-o "Port=${DEST_IP##*:}")
+fi
+NAME=$(basename "${BINARY}")
+TARGET="${DEST_DIR}/${NAME}"
+CACHED="${DEPLOY_CACHE}/${DEST_IP}${DEST_DIR}/${NAME}"
+
+if ! [[ ${DEPLOY_KEEP} =~ ^[0-9]+$ ]]; then
+    log_error "DEPLOY_KEEP must be a number of versions, not '${DEPLOY_KEEP}'"
+    exit 1
+fi
+
+# Validate binary exists (a rollback only needs its name)
+if [ ${ROLLBACK} -eq 0 ] && [ ! -f "${BINARY}" ]; then
     log_error "Binary file '${BINARY}' not found!"
     log_info "Run 'make' first to build the binary."
     exit 1
 fi
 
 # Check if sshpass is available
-if ! command -v sshpass &> /dev/null; then
+if [ "${DEST_IP}" != local ] && ! command -v sshpass &> /dev/null; then
     log_error "sshpass is not installed. Install it with: sudo apt install sshpass"
     exit 1
 fi
 
-log_info "Deploying to ${USER}@${DEST_IP}:${DEST_DIR}/${BINARY}"
+# Run a shell command on the target (stdin is forwarded)
+remote() {
+    if [ "${DEST_IP}" = local ]; then
+        sh -c "$1"
+    else
+        sshpass -p "${PASS}" ssh "${SSH_OPTS[@]}" "${USER}@${SSH_HOST}" "$1"
+    fi
+}
+
+now_ms() {
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+# Per-step timing: step_end <name> records the time since the last step
+STEPS=""
+step_end() {
+    local now
+    now=$(now_ms)
+    STEPS="${STEPS}${STEPS:+, }$1 $((now - STEP_MS)) ms"
+    STEP_MS=${now}
+}
+
+# Shell snippet that points ${TARGET} at release directory $1 (relative to
+# DEST_DIR): a new symlink renamed over the old one, so there is no moment
+# without a binary. A plain binary left by an older deploy.sh is kept as
+# the oldest release first so it can be rolled back to.
+switch_to() {
+    echo "cd '${DEST_DIR}' && \
+if [ -f '${NAME}' ] && [ ! -L '${NAME}' ]; then \
+    old=releases/'${NAME}'-00000000-000000.000-\$(sha256sum < '${NAME}' | cut -c1-12); \
+    mkdir -p \"\$old\" && cp -p '${NAME}' \"\$old/${NAME}\"; \
+fi && \
+ln -sfn '$1/${NAME}' '${NAME}.link' && mv -f '${NAME}.link' '${NAME}'"
+}
+
+# Release directory names of this binary (grep -x), so releases of another
+# binary whose name starts with "${NAME}-" are never taken for ours
+RELEASE_RE="$(printf '%s' "${NAME}" | sed 's/[].[*^$\\]/\\&/g')-[0-9]\{8\}-[0-9]\{6\}\.[0-9]\{3\}-[0-9a-f]\{12\}"
+
+# Shell snippet that deletes all but the DEPLOY_KEEP newest releases besides
+# the active one (release names sort by deploy time)
+PRUNE="cd '${DEST_DIR}/releases' && active=\$(readlink '../${NAME}' | cut -d/ -f2) && \
+ls -1 | grep -x '${RELEASE_RE}' | sort -r | grep -vx \"\$active\" | tail -n +$((DEPLOY_KEEP + 1)) | \
+while read -r old; do rm -rf \"\$old\"; done; exit 0"
+
+WORK=$(mktemp -d)
+cleanup() {
+    rm -rf "${WORK}"
+    if [ "${DEST_IP}" != local ] && [ "${DEPLOY_CONTROL_PERSIST}" = 0 ]; then
+        ssh "${SSH_OPTS[@]}" -O exit "${USER}@${SSH_HOST}" 2> /dev/null || true
+    fi
+}
+trap cleanup EXIT
+
+if [ ${ROLLBACK} -eq 1 ]; then
+    log_info "Rolling back ${USER}@${DEST_IP}:${TARGET}"
+else
+    log_info "Deploying to ${USER}@${DEST_IP}:${TARGET}"
+    LOCAL_SUM=$(sha256sum "${BINARY}" | cut -d' ' -f1)
+    BINARY_BYTES=$(stat -c %s "${BINARY}")
+fi
+START_MS=$(now_ms)
+STEP_MS=${START_MS}
+
+# Open the shared connection (the only password authentication) unless a
+# previous deploy left one running
+if [ "${DEST_IP}" != local ]; then
+    if ssh "${SSH_OPTS[@]}" -O check "${USER}@${SSH_HOST}" 2> /dev/null; then
+        log_info "Reusing open connection to ${SSH_HOST}"
+    else
+        sshpass -p "${PASS}" ssh "${SSH_OPTS[@]}" -fN "${USER}@${SSH_HOST}"
+    fi
+    step_end connect
+fi
+
+# Find out what the target has: tools, the active binary, the releases and
+# the checksum of any kept release of the binary being deployed
+PROBE=$(remote "mkdir -p '${DEST_DIR}/releases'; \
+    for tool in rsync bspatch gzip xz; do command -v \$tool > /dev/null 2>&1 && echo have-\$tool; done; \
+    echo active \$(readlink '${TARGET}'); \
+    sha256sum '${TARGET}' 2>/dev/null; \
+    cd '${DEST_DIR}/releases' && ls -1 | grep -x '${RELEASE_RE}' | while read -r release; do \
+        echo release \$release; \
+        case \$release in *-${LOCAL_SUM:0:12}) \
+            echo kept \$release \$(sha256sum < \$release/'${NAME}' 2>/dev/null | cut -d' ' -f1) ;; esac; \
+    done; exit 0") || true
+REMOTE_SUM=$(echo "${PROBE}" | awk 'length($1) == 64 { print $1 }')
+ACTIVE=$(echo "${PROBE}" | awk '$1 == "active" { split($2, path, "/"); print path[2] }')
+RELEASES=$(echo "${PROBE}" | awk '$1 == "release" { print $2 }' | sort)
+remote_has() {
+    echo "${PROBE}" | grep -qx "have-$1"
+}
+step_end probe
+
+# Replace the previous debug session with one on the active version; only
+# called once the switch is done, so the old session runs until then.
+# (The anchored pattern keeps pkill from matching the shell running it.)
+start_gdbserver() {
+    if [ "${DEPLOY_GDBSERVER}" != 1 ]; then
+        exit 0
+    fi
+    log_info "Starting gdbserver on ${SSH_HOST}:${DEBUG_PORT}..."
+    if [ "${DEST_IP}" = local ]; then
+        pkill -f '^([^ ]*/)?gdbserver ' 2>/dev/null || true
+        # Not exec'd, so the EXIT trap still cleans up when gdbserver ends
+        cd "${DEST_DIR}" && gdbserver "localhost:${DEBUG_PORT}" "./${NAME}"
+        exit
+    fi
+    ssh -t "${SSH_OPTS[@]}" \
+        "${USER}@${SSH_HOST}" \
+        "pkill -f '^([^ ]*/)?gdbserver ' 2>/dev/null; sleep 0.2; cd ${DEST_DIR}; gdbserver localhost:${DEBUG_PORT} ${NAME}"
+    exit
+}
+
+# Rollback: switch to the newest release older than the active one
+if [ ${ROLLBACK} -eq 1 ]; then
+    PREVIOUS=$(echo "${RELEASES}" | awk -v active="${ACTIVE}" '$0 == active { exit } { previous = $0 } END { print previous }')
+    if [ -z "${ACTIVE}" ] || [ -z "${PREVIOUS}" ] || ! echo "${RELEASES}" | grep -qx "${ACTIVE}"; then
+        log_error "No release older than '${ACTIVE:-none}' kept in ${DEST_DIR}/releases"
+        exit 1
+    fi
+    remote "$(switch_to "releases/${PREVIOUS}")"
+    step_end switch
+    log_info "Rolled back ${NAME}: ${ACTIVE} -> ${PREVIOUS}, $(( $(now_ms) - START_MS )) ms"
+    log_info "Steps: ${STEPS}"
+    start_gdbserver
+fi
+
+# The version being deployed: a kept release whose binary still has the
+# local sha256, or a new one
+KEPT=$(echo "${PROBE}" | awk -v sum="${LOCAL_SUM}" '$1 == "kept" && $3 == sum { print $2 }' | sort | tail -1)
+RELEASE_DIR="releases/${KEPT}"
+if [ -z "${KEPT}" ]; then
+    RELEASE_DIR="releases/${NAME}-$(date -u +%Y%m%d-%H%M%S.%3N)-${LOCAL_SUM:0:12}"
+fi
+RELEASE="${DEST_DIR}/${RELEASE_DIR}"
+NEW="${RELEASE}/${NAME}.new"
+
+# Choose the cheapest transfer both sides support
+METHOD="${DEPLOY_TRANSFER}"
+if [ "${REMOTE_SUM}" = "${LOCAL_SUM}" ]; then
+    METHOD=none
+elif [ -n "${KEPT}" ]; then
+    METHOD=relink
+elif [ "${METHOD}" = auto ]; then
+    METHOD=full
+    if [ -n "${REMOTE_SUM}" ] && command -v rsync &> /dev/null && remote_has rsync; then
+        METHOD=rsync
+    elif [ -f "${CACHED}" ] && [ "$(sha256sum "${CACHED}" | cut -d' ' -f1)" = "${REMOTE_SUM}" ] &&
+         command -v bsdiff &> /dev/null && remote_has bspatch; then
+        METHOD=bsdiff
+    fi
+fi
+# A forced method must be usable
+case "${METHOD}" in
+    rsync)
+        if ! command -v rsync &> /dev/null || ! remote_has rsync; then
+            log_error "DEPLOY_TRANSFER=rsync needs rsync here and on the target"
+            exit 1
+        elif [ -z "${REMOTE_SUM}" ]; then
+            log_error "The target has no ${NAME} to send an rsync delta against, use full"
+            exit 1
+        fi ;;
+    bsdiff)
+        if ! command -v bsdiff &> /dev/null || ! remote_has bspatch; then
+            log_error "DEPLOY_TRANSFER=bsdiff needs bsdiff here and bspatch on the target"
+            exit 1
+        elif [ ! -f "${CACHED}" ] || [ "$(sha256sum "${CACHED}" | cut -d' ' -f1)" != "${REMOTE_SUM}" ]; then
+            log_error "The target's binary was not deployed from here (no base in ${DEPLOY_CACHE}), use full"
+            exit 1
+        fi ;;
+esac
+case "${DEPLOY_COMPRESS}" in
+    gzip) COMPRESS="gzip -9c";  DECOMPRESS="gzip -dc" ;;
+    xz)   COMPRESS="xz -9c";    DECOMPRESS="xz -dc" ;;
+    none) COMPRESS="cat";       DECOMPRESS="cat" ;;
+    *)    log_error "Unknown DEPLOY_COMPRESS=${DEPLOY_COMPRESS}"; exit 1 ;;
+esac
+if [ "${METHOD}" = full ] && [ "${DEPLOY_COMPRESS}" != none ] && ! remote_has "${DEPLOY_COMPRESS}"; then
+    log_warn "Target has no ${DEPLOY_COMPRESS}, sending uncompressed"
+    COMPRESS="cat"; DECOMPRESS="cat"
+fi
 
-# Kill existing gdbserver on target and delete old binary
-log_info "Cleaning up previous deployment..."
-sshpass -p "${PASS}" ssh -o StrictHostKeyChecking=no -o ConnectTimeout=10 \
-    "${USER}@${DEST_IP}" \
-    "sh -c 'pkill -f gdbserver 2>/dev/null; rm -rf ${DEST_DIR}/${BINARY}; exit 0'" || true
+# Check ${NEW} against the local sha256, complete the release and switch
+# to it, then prune old releases; exits 3 on a mismatch. Appended to the
+# upload command where possible so upload and activation share one session.
+ACTIVATE="if [ \"\$(sha256sum < '${NEW}' | cut -d' ' -f1)\" = '${LOCAL_SUM}' ]; then \
+    chmod +x '${NEW}' && mv -f '${NEW}' '${RELEASE}/${NAME}' && $(switch_to "${RELEASE_DIR}") || exit \$?; \
+else rm -rf '${RELEASE}'; exit 3; fi; ${PRUNE}"
 
-# Send binary to target
-log_info "Uploading binary..."
-sshpass -p "${PASS}" scp -o StrictHostKeyChecking=no -o ConnectTimeout=10 \
-    "${BINARY}" "${USER}@${DEST_IP}:${DEST_DIR}/${BINARY}"
+# Upload to ${NEW} and activate; SENT is the payload size in bytes
+SENT=0
+STATUS=0
+case "${METHOD}" in
+    none)
+        log_info "Target already has this binary (sha256 ${LOCAL_SUM:0:12}), nothing to send"
+        ;;
+    relink)
+        log_info "Target keeps this binary in ${RELEASE_DIR} (sha256 checked), switching back to it"
+        remote "$(switch_to "${RELEASE_DIR}") && ${PRUNE}" || STATUS=$?
+        step_end switch
+        ;;
+    rsync)
+        log_info "Uploading rsync delta..."
+        # The old binary is the basis for the delta
+        remote "mkdir -p '${RELEASE}' && cp -f '${TARGET}' '${NEW}'" || STATUS=$?
+        if [ ${STATUS} -eq 0 ]; then
+            if [ "${DEST_IP}" = local ]; then
+                rsync --no-whole-file --compress --stats "${BINARY}" "${NEW}" > "${WORK}/rsync.log" || STATUS=$?
+            else
+                SSHPASS="${PASS}" rsync --compress --stats -e "sshpass -e ssh ${SSH_OPTS[*]}" \
+                    "${BINARY}" "${USER}@${SSH_HOST}:${NEW}" > "${WORK}/rsync.log" || STATUS=$?
+            fi
+            SENT=$(awk -F': ' '/^Total bytes (sent|received)/ { gsub(",", "", $2); n += $2 } END { print n + 0 }' \
+                "${WORK}/rsync.log")
+        fi
+        step_end upload
+        [ ${STATUS} -eq 0 ] && { remote "${ACTIVATE}" || STATUS=$?; }
+        step_end verify
+        ;;
+    bsdiff)
+        log_info "Uploading bsdiff patch against the last deployed binary..."
+        bsdiff "${CACHED}" "${BINARY}" "${WORK}/patch"
+        SENT=$(stat -c %s "${WORK}/patch")
+        remote "mkdir -p '${RELEASE}' && cat > '${NEW}.patch' && bspatch '${TARGET}' '${NEW}' '${NEW}.patch'; \
+            status=\$?; rm -f '${NEW}.patch'; [ \$status -eq 0 ] || exit \$status; ${ACTIVATE}" \
+            < "${WORK}/patch" || STATUS=$?
+        step_end upload+verify
+        ;;
+    full)
+        log_info "Uploading binary (${DEPLOY_COMPRESS})..."
+        ${COMPRESS} "${BINARY}" > "${WORK}/payload"
+        SENT=$(stat -c %s "${WORK}/payload")
+        remote "mkdir -p '${RELEASE}' && ${DECOMPRESS} > '${NEW}' && ${ACTIVATE}" < "${WORK}/payload" || STATUS=$?
+        step_end upload+verify
+        ;;
+    *)
+        log_error "Unknown DEPLOY_TRANSFER=${DEPLOY_TRANSFER} (auto, rsync, bsdiff or full)"
+        exit 1
+        ;;
+esac
 
-# Make binary executable
-sshpass -p "${PASS}" ssh -o StrictHostKeyChecking=no \
-    "${USER}@${DEST_IP}" "chmod +x ${DEST_DIR}/${BINARY}"
+if [ ${STATUS} -eq 3 ]; then
+    log_error "Checksum mismatch on the target, ${TARGET} left unchanged"
+    exit 1
+elif [ ${STATUS} -ne 0 ]; then
+    [ "${METHOD}" != relink ] && { remote "[ \"\$(readlink '${TARGET}')\" = '${RELEASE_DIR}/${NAME}' ] || rm -rf '${RELEASE}'" || true; }
+    log_error "Upload failed (exit ${STATUS}), ${TARGET} left unchanged"
+    exit 1
+fi
+if [ "${METHOD}" != none ] && [ "${METHOD}" != relink ]; then
+    mkdir -p "$(dirname "${CACHED}")"
+    cp -f "${BINARY}" "${CACHED}"
+fi
 
-# Start gdbserver on target
-log_info "Starting gdbserver on ${DEST_IP}:${DEBUG_PORT}..."
-sshpass -p "${PASS}" ssh -t -o StrictHostKeyChecking=no \
-    "${USER}@${DEST_IP}" \
-    "sh -c 'cd ${DEST_DIR}; gdbserver localhost:${DEBUG_PORT} ${BINARY}'"
+# What the target's copy was checked against the local sha256 as
+case "${METHOD}" in
+    none)   CHECKED="active binary matches" ;;
+    relink) CHECKED="kept release matches" ;;
+    *)      CHECKED="upload verified" ;;
+esac
+ELAPSED_MS=$(( $(now_ms) - START_MS ))
+log_info "Deployed ${NAME}: ${METHOD}, ${SENT} of ${BINARY_BYTES} bytes sent, sha256 ${CHECKED}, $(awk -v ms="${ELAPSED_MS}" 'BEGIN { printf "%.2f", ms / 1000 }')s"
+log_info "Steps: ${STEPS}"
+start_gdbserver
 
 # ============================================================================
 # Alternative: Run with root privileges (uncomment if needed)
 # ============================================================================
 # sshpass -p "${PASS}" ssh -t "${USER}@${DEST_IP}" \
-#     "cd ${DEST_DIR}; echo '${PASS}' | sudo -S gdbserver localhost:${DEBUG_PORT} ${BINARY}"
\ No newline at end of file
+#     "cd ${DEST_DIR}; echo '${PASS}' | sudo -S gdbserver localhost:${DEBUG_PORT} ${BINARY}"
@@ -0,0 +1,73 @@
+/**
+ * @file alloc_tracker.h
+ * @brief Heap allocation tracking per program phase
+ *
+ * Built with ALLOC_TRACK=1 (defines ALLOC_TRACKING), src/malloc_hooks.cpp
+ * interposes malloc/calloc/realloc/free and the aligned variants and feeds
+ * src/alloc_tracker.cpp. operator new/delete are covered because libstdc++
+ * implements them on top of malloc.
+ *
+ * The application marks phase transitions. Any allocation in PHASE_STEADY is
+ * a violation: it is reported with its call site (full backtrace in debug
+ * builds) and, when ALLOC_TRACK_POLICY=abort is set, aborts the process.
+ * Without ALLOC_TRACKING every call below compiles to nothing.
+ */
+
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <cstdint>
+
+// Program phases used to attribute allocations
+enum class AllocPhase {
+    PHASE_INIT = 0,      // startup, allocations are budgeted
+    PHASE_STEADY = 1,    // mainLoop running, allocations are violations
+    PHASE_SHUTDOWN = 2,  // teardown, allocations are counted only
+    PHASE_COUNT = 3
+};
+
+// Counters for one phase
+struct AllocPhaseStats {
+    uint64_t allocations;  // malloc-family calls that returned memory
+    uint64_t frees;        // free() calls with a non-null pointer
+    uint64_t bytes;        // requested bytes
+    uint64_t peakLive;     // highest live heap bytes seen during the phase
+};
+
+// Environment variable selecting the steady-state policy ("warn" or "abort")
+#define ALLOC_TRACK_POLICY_ENV "ALLOC_TRACK_POLICY"
+
+// Steady-state violations printed in full before only counting the rest
+#define ALLOC_TRACK_MAX_REPORTS 16
+
+// Distinct init-phase call sites kept for the budget summary
+#define ALLOC_TRACK_MAX_SITES 64
+
+#ifdef ALLOC_TRACKING
+
+class AllocTracker {
+public:
+    // Switch phase; entering PHASE_STEADY prints the init-phase summary
+    static void setPhase(AllocPhase phase);
+
+    static AllocPhase phase();
+
+    static AllocPhaseStats stats(AllocPhase phase);
+
+    // Log per-phase totals and the steady-state violation count
+    static void report();
+};
+
+#else
+
+class AllocTracker {
+public:
+    static void setPhase(AllocPhase) {}
+    static AllocPhase phase() { return AllocPhase::PHASE_INIT; }
+    static AllocPhaseStats stats(AllocPhase) { return AllocPhaseStats{0, 0, 0, 0}; }
+    static void report() {}
+};
+
+#endif  // ALLOC_TRACKING
+
+#endif  // ALLOC_TRACKER_H
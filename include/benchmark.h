@@ -0,0 +1,130 @@
+/**
+ * @file benchmark.h
+ * @brief Self-contained micro-benchmark harness
+ *
+ * Benchmarks register themselves at static-initialization time and run from
+ * main() with --bench. Each one gets a BenchState and loops while next()
+ * returns true; setup before the loop is not timed:
+ *
+ *   static void benchFoo(BenchState &state) {
+ *       Foo foo;
+ *       while (state.next()) {
+ *           doNotOptimize(foo.compute());
+ *       }
+ *   }
+ *   BENCHMARK("foo/compute", benchFoo, 100000);
+ *
+ * A run does BENCH_DEFAULT_WARMUP untimed batches and then
+ * BENCH_DEFAULT_REPETITIONS timed batches of N iterations, reporting
+ * min/median/mean/max and the coefficient of variation of ns/op. Results go
+ * to stdout as "bench <name> <median> ns/op ..." lines and optionally to a
+ * JSON file. Only the C++ standard library and POSIX clocks are used, so
+ * the harness builds with every toolchain in the Makefile.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <ctime>
+
+// Registered benchmarks (static table, no allocation)
+#define BENCH_MAX_CASES 32
+
+// Timed batches kept for statistics
+#define BENCH_MAX_REPETITIONS 64
+
+// --bench-context=<key>=<value> entries stored in the JSON "run" object
+#define BENCH_MAX_CONTEXT 8
+
+/**
+ * Prevent the compiler from discarding @p value or the computation behind
+ * it, without adding a store to memory.
+ */
+template <typename T>
+inline void doNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Force pending writes to memory to be treated as observable
+inline void clobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+class BenchState {
+public:
+    explicit BenchState(long iterations)
+        : iterations_(iterations), remaining_(iterations), started_(false), elapsedNs_(0) {}
+
+    // True while iterations remain; the first call starts the timer
+    bool next() {
+        if (!started_) {
+            started_ = true;
+            clock_gettime(CLOCK_MONOTONIC, &start_);
+        }
+        if (remaining_ > 0) {
+            remaining_--;
+            return true;
+        }
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        elapsedNs_ = (end.tv_sec - start_.tv_sec) * 1000000000LL + (end.tv_nsec - start_.tv_nsec);
+        return false;
+    }
+
+    long iterations() const {
+        return iterations_;
+    }
+
+    int64_t elapsedNs() const {
+        return elapsedNs_;
+    }
+
+private:
+    long iterations_;
+    long remaining_;
+    bool started_;
+    struct timespec start_;
+    int64_t elapsedNs_;
+};
+
+typedef void (*BenchFunction)(BenchState &state);
+
+// Command-line selectable settings for one run
+struct BenchOptions {
+    long iterations;        // per batch; 0 uses each benchmark's default
+    int repetitions;        // timed batches
+    int warmup;             // untimed batches before timing
+    const char *filter;     // exact name or "<group>" prefix of "<group>/...", null for all
+    const char *jsonPath;   // JSON results file, null for none
+    const char *arch;       // context stored in the JSON output, with uname()
+    const char *mode;
+    const char *board;
+    const char *runtime;
+    const char *context[BENCH_MAX_CONTEXT];  // "<key>=<value>" describing the run
+    int contextCount;
+};
+
+class Benchmarks {
+public:
+    // Register @p function under @p name, run for @p iterations per batch
+    static void add(const char *name, BenchFunction function, long iterations);
+
+    // Run matching benchmarks; returns the number run or -1 on error
+    static int run(const BenchOptions &options);
+};
+
+struct BenchRegistrar {
+    BenchRegistrar(const char *name, BenchFunction function, long iterations) {
+        Benchmarks::add(name, function, iterations);
+    }
+};
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+
+// Register a benchmark function at static-initialization time
+#define BENCHMARK(name, function, iterations) \
+    static BenchRegistrar BENCH_CONCAT(g_benchRegistrar, __LINE__)(name, function, iterations)
+
+#endif  // BENCHMARK_H
@@ -29,10 +29,31 @@
 // Utility macros
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
 #define UNUSED(x) ((void)(x))
+#define STRINGIFY(x) STRINGIFY_IMPL(x)
+#define STRINGIFY_IMPL(x) #x
 
 // Timing constants (in microseconds)
 #define LOOP_DELAY_US (500 * 1000)  // 500ms
 
+// Data pipeline settings
+#define PIPELINE_QUEUE_CAPACITY 64                // items per inter-stage queue
+#define PIPELINE_FILTER_ALPHA 0.2                 // low-pass filter coefficient
+#define PIPELINE_TOPOLOGY_ENV "PIPELINE_TOPOLOGY"  // stage placement override
+
+// Thread stack settings
+#define THREAD_STACK_SIZE_DEFAULT (256 * 1024)  // bytes per worker thread
+#define THREAD_STACK_SIZE_ENV "THREAD_STACK_SIZE"  // override in KiB
+
+// Memory pool settings
+#define MESSAGE_POOL_BLOCK_SIZE 64     // bytes per pipeline message / log record
+#define MESSAGE_POOL_BLOCK_COUNT 256   // blocks preallocated at startup
+#define TICK_ARENA_SIZE (16 * 1024)    // scratch bytes per mainLoop iteration
+
+// Benchmark harness (--bench[=N], see benchmark.h)
+#define BENCH_DEFAULT_ITERATIONS 100000  // per batch, when a benchmark sets none
+#define BENCH_DEFAULT_REPETITIONS 5      // timed batches per benchmark
+#define BENCH_DEFAULT_WARMUP 1           // untimed batches before timing
+
 // String buffer sizes
 #define MAX_USERNAME_LEN 256
 #define MAX_HOSTNAME_LEN 256
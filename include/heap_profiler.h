@@ -0,0 +1,73 @@
+/**
+ * @file heap_profiler.h
+ * @brief Low-overhead sampling heap profiler
+ *
+ * Built with HEAP_PROFILE=1 (defines HEAP_PROFILING). Allocations are sampled
+ * on average once every HEAP_PROFILE_RATE bytes using a Poisson process, the
+ * same scheme tcmalloc uses, so large allocations are almost always seen and
+ * small ones proportionally. Each sample records its call stack; live bytes
+ * per stack are tracked until the block is freed.
+ *
+ * A profile is written on SIGUSR2 (serviced from mainLoop via poll()) and at
+ * shutdown, in two formats:
+ *   <prefix>.heap    gperftools heap_v2 text, readable by pprof
+ *   <prefix>.folded  estimated live bytes per stack for flamegraph.pl
+ *
+ * Runtime settings: HEAP_PROFILE_RATE=<bytes>, HEAP_PROFILE_PREFIX=<path>.
+ * Without HEAP_PROFILING every call below compiles to nothing.
+ */
+
+#ifndef HEAP_PROFILER_H
+#define HEAP_PROFILER_H
+
+#include <cstdint>
+
+// Mean bytes between samples (tcmalloc default)
+#define HEAP_PROFILE_DEFAULT_RATE (512 * 1024)
+
+// Environment variables read by HeapProfiler::start()
+#define HEAP_PROFILE_RATE_ENV "HEAP_PROFILE_RATE"
+#define HEAP_PROFILE_PREFIX_ENV "HEAP_PROFILE_PREFIX"
+
+// Default output prefix; the pid and a dump sequence number are appended
+#define HEAP_PROFILE_DEFAULT_PREFIX "/tmp/firmware"
+
+// Table sizes (static storage, no allocation inside the profiler)
+#define HEAP_PROFILE_MAX_DEPTH 16   // frames recorded per sample
+#define HEAP_PROFILE_MAX_STACKS 512  // distinct call stacks
+#define HEAP_PROFILE_MAX_LIVE 4096   // sampled blocks tracked until freed
+
+#ifdef HEAP_PROFILING
+
+class HeapProfiler {
+public:
+    // Read settings from the environment and install the SIGUSR2 handler
+    static void start();
+
+    // Async-signal-safe: ask for a dump on the next poll()
+    static void requestDump();
+
+    // Write a pending dump (call from the event loop)
+    static void poll();
+
+    // Write <prefix>.<pid>.<seq>.heap/.folded now
+    static bool dump();
+
+    // Log sampled totals
+    static void logSummary();
+};
+
+#else
+
+class HeapProfiler {
+public:
+    static void start() {}
+    static void requestDump() {}
+    static void poll() {}
+    static bool dump() { return false; }
+    static void logSummary() {}
+};
+
+#endif  // HEAP_PROFILING
+
+#endif  // HEAP_PROFILER_H
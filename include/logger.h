@@ -37,11 +37,28 @@ public:
         minLevel_ = level;
     }
 
+    LogLevel getLevel() const {
+        return minLevel_;
+    }
+
     // Set output file (default is stdout)
     void setOutput(FILE *output) {
         output_ = output;
     }
 
+    FILE *getOutput() const {
+        return output_;
+    }
+
+    // Format the current local time as "YYYY-MM-DD HH:MM:SS"
+    // (localtime_r() avoids glibc re-reading TZ and allocating on every call)
+    static void getTimestamp(char *buffer, size_t size) {
+        time_t now = time(nullptr);
+        struct tm tm_info;
+        localtime_r(&now, &tm_info);
+        strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &tm_info);
+    }
+
     // Main log function
     void log(LogLevel level, const char *func, const char *file, int line,
              const char *fmt, ...) {
@@ -56,6 +73,10 @@ public:
         // Get just the filename (not full path)
         const char *filename = getFilename(file);
 
+        // One record per lock, so lines from pipeline stage threads
+        // never interleave
+        flockfile(output_);
+
         // Print header: timestamp + level + function + file:line
         fprintf(output_, "%s %s [%s] [%s:%d] : ",
                 timestamp,
@@ -72,6 +93,7 @@ public:
 
         fprintf(output_, "\n");
         fflush(output_);
+        funlockfile(output_);
     }
 
 private:
@@ -94,12 +116,6 @@ private:
         }
     }
 
-    static void getTimestamp(char *buffer, size_t size) {
-        time_t now = time(nullptr);
-        struct tm *tm_info = localtime(&now);
-        strftime(buffer, size, "%Y-%m-%d %H:%M:%S", tm_info);
-    }
-
     static const char* getFilename(const char *path) {
         const char *slash = strrchr(path, '/');
         if (slash) {
@@ -0,0 +1,50 @@
+/**
+ * @file malloc_hooks.h
+ * @brief Internal dispatch from the interposed malloc family
+ *
+ * src/malloc_hooks.cpp replaces malloc/calloc/realloc/free and the aligned
+ * variants whenever ALLOC_TRACKING or HEAP_PROFILING is defined, forwards to
+ * glibc's __libc_* implementations and reports each event to the enabled
+ * consumers below. Consumers run inside the allocator and must not allocate.
+ */
+
+#ifndef MALLOC_HOOKS_H
+#define MALLOC_HOOKS_H
+
+#include <cstddef>
+
+#if defined(ALLOC_TRACKING) || defined(HEAP_PROFILING)
+#define MALLOC_HOOKS 1
+#endif
+
+#ifdef ALLOC_TRACKING
+// src/alloc_tracker.cpp
+void allocTrackerOnAllocate(size_t size, size_t usable, void *caller);
+void allocTrackerOnFree(size_t usable);
+#endif
+
+#ifdef HEAP_PROFILING
+// src/heap_profiler.cpp
+void heapProfilerOnAllocate(void *ptr, size_t size, void *caller);
+void heapProfilerOnFree(void *ptr);
+
+// A sampled block taken out of the live set while realloc() runs
+struct HeapProfilerBlock {
+    void *ptr;
+    size_t size;
+    double estimate;
+    int bucket;
+};
+// Remove @p ptr from the live set before it can be released and reused by
+// another thread; returns false when it was not sampled
+bool heapProfilerDetach(void *ptr, HeapProfilerBlock *saved);
+// Put a detached block back (realloc() failed and the block is still live)
+void heapProfilerRestore(const HeapProfilerBlock &saved);
+#endif
+
+#ifdef MALLOC_HOOKS
+// Describe a code address as "symbol (module+0xoffset)" without allocating
+void mallocHooksFormatAddress(const void *address, char *buffer, size_t size);
+#endif
+
+#endif  // MALLOC_HOOKS_H
@@ -0,0 +1,471 @@
+/**
+ * @file memory_pool.h
+ * @brief Fixed-size slab pool and monotonic arena allocators
+ *
+ * SlabPool hands out equally sized blocks carved from one preallocated slab.
+ * Each thread keeps a small lock-free cache of blocks per pool; the shared
+ * free list is only locked to refill or drain that cache in batches.
+ *
+ * MonotonicArena is a bump allocator for short-lived data that is released
+ * all at once, e.g. by calling reset() at the top of every mainLoop tick.
+ *
+ * Debug builds (or -DPOOL_POISON) fill freed memory with a pattern and check
+ * it on reuse, so writes after free are reported.
+ *
+ * A SlabPool must outlive every thread that used it; join workers before the
+ * pool is destroyed.
+ */
+
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "logger.h"
+
+#if defined(DEBUG) && !defined(POOL_POISON)
+#define POOL_POISON 1
+#endif
+
+// Poison patterns (debug builds only)
+#define POOL_POISON_ALLOC 0xCD  // freshly allocated, not yet written
+#define POOL_POISON_FREE  0xDD  // returned to the pool
+
+// Per-thread cache sizing
+#define POOL_TLS_CACHE_SIZE 32  // blocks cached per thread and pool
+#define POOL_TLS_BATCH      16  // blocks moved per refill/drain
+#define POOL_MAX_TLS_POOLS  8   // pools a single thread can cache for
+
+// Point-in-time copy of allocator counters
+struct PoolStats {
+    uint64_t allocations;  // successful allocate() calls
+    uint64_t frees;        // deallocate() calls
+    uint64_t failures;     // allocate() calls that found the pool exhausted
+    uint64_t inUse;        // bytes or blocks currently handed out
+    uint64_t peak;         // high-water mark of inUse
+};
+
+class SlabPool {
+public:
+    SlabPool(const char *name, size_t blockSize, size_t blockCount)
+        : name_(name), blockSize_(roundBlockSize(blockSize)), blockCount_(blockCount),
+          slab_(static_cast<unsigned char *>(::operator new(blockSize_ * blockCount))),
+          freeList_(nullptr), freeCount_(0), allocations_(0), frees_(0), failures_(0), inUse_(0),
+          peak_(0) {
+        // Thread the free list through the blocks, lowest address first
+        for (size_t i = blockCount_; i-- > 0;) {
+            void *block = slab_ + i * blockSize_;
+            poison(block, POOL_POISON_FREE);
+            *static_cast<void **>(block) = freeList_;
+            freeList_ = block;
+        }
+        freeCount_ = blockCount_;
+    }
+
+    ~SlabPool() {
+        detachThreadCache();
+        ::operator delete(slab_);
+    }
+
+    // Non-copyable
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    /**
+     * Returns nullptr when the pool is exhausted. Blocks parked in other
+     * threads' caches (up to POOL_TLS_CACHE_SIZE each) are not reclaimed.
+     */
+    void *allocate() {
+        ThreadCache *cache = threadCache();
+        void *block = nullptr;
+        if (cache == nullptr) {
+            block = popShared();
+        } else if (cache->count > 0 || refill(cache)) {
+            block = cache->blocks[--cache->count];
+        }
+
+        if (block == nullptr) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return handOut(block);
+    }
+
+    void deallocate(void *block) {
+        if (block == nullptr) {
+            return;
+        }
+        if (!owns(block)) {
+            LOG_ERROR("SlabPool %s: %p does not belong to this pool", name_, block);
+            return;
+        }
+        poison(block, POOL_POISON_FREE);
+        frees_.fetch_add(1, std::memory_order_relaxed);
+        inUse_.fetch_sub(1, std::memory_order_relaxed);
+
+        ThreadCache *cache = threadCache();
+        if (cache == nullptr) {
+            pushShared(block);
+            return;
+        }
+        if (cache->count == POOL_TLS_CACHE_SIZE) {
+            drain(cache, POOL_TLS_BATCH);
+        }
+        cache->blocks[cache->count++] = block;
+    }
+
+    // Typed helpers (T must fit in blockSize())
+    template <typename T, typename... Args>
+    T *create(Args &&...args) {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned type");
+        if (sizeof(T) > blockSize_) {
+            LOG_ERROR("SlabPool %s: object of %zu bytes exceeds block size %zu", name_, sizeof(T),
+                      blockSize_);
+            return nullptr;
+        }
+        void *block = allocate();
+        return block ? new (block) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    template <typename T>
+    void destroy(T *object) {
+        if (object != nullptr) {
+            object->~T();
+            deallocate(object);
+        }
+    }
+
+    bool owns(const void *block) const {
+        const unsigned char *p = static_cast<const unsigned char *>(block);
+        return p >= slab_ && p < slab_ + blockSize_ * blockCount_ &&
+               static_cast<size_t>(p - slab_) % blockSize_ == 0;
+    }
+
+    size_t blockSize() const {
+        return blockSize_;
+    }
+
+    size_t blockCount() const {
+        return blockCount_;
+    }
+
+    PoolStats stats() const {
+        PoolStats s;
+        s.allocations = allocations_.load(std::memory_order_relaxed);
+        s.frees = frees_.load(std::memory_order_relaxed);
+        s.failures = failures_.load(std::memory_order_relaxed);
+        s.inUse = static_cast<uint64_t>(inUse_.load(std::memory_order_relaxed));
+        s.peak = static_cast<uint64_t>(peak_.load(std::memory_order_relaxed));
+        return s;
+    }
+
+    void logStats() const {
+        PoolStats s = stats();
+        LOG_INFO("Pool %-10s %4zu B x %-5zu alloc %llu  free %llu  fail %llu  in use %llu  peak %llu",
+                 name_, blockSize_, blockCount_, static_cast<unsigned long long>(s.allocations),
+                 static_cast<unsigned long long>(s.frees), static_cast<unsigned long long>(s.failures),
+                 static_cast<unsigned long long>(s.inUse), static_cast<unsigned long long>(s.peak));
+    }
+
+private:
+    struct ThreadCache {
+        SlabPool *owner;
+        size_t count;
+        void *blocks[POOL_TLS_CACHE_SIZE];
+    };
+
+    // Per-thread cache table; returns cached blocks to their pools on thread exit
+    struct ThreadCacheTable {
+        ThreadCache caches[POOL_MAX_TLS_POOLS];
+
+        ThreadCacheTable() {
+            memset(caches, 0, sizeof(caches));
+        }
+
+        ~ThreadCacheTable() {
+            for (auto &cache : caches) {
+                if (cache.owner != nullptr) {
+                    cache.owner->drain(&cache, cache.count);
+                    cache.owner = nullptr;
+                }
+            }
+            threadTableDestroyed() = true;
+        }
+    };
+
+    static ThreadCacheTable &threadTable() {
+        static thread_local ThreadCacheTable table;
+        return table;
+    }
+
+    // Set once this thread's table is gone (late frees then use the shared list)
+    static bool &threadTableDestroyed() {
+        static thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    // Find or claim this thread's cache for the pool (nullptr if unavailable)
+    ThreadCache *threadCache() {
+        if (threadTableDestroyed()) {
+            return nullptr;
+        }
+        ThreadCacheTable &table = threadTable();
+        ThreadCache *freeSlot = nullptr;
+        for (auto &cache : table.caches) {
+            if (cache.owner == this) {
+                return &cache;
+            }
+            if (cache.owner == nullptr && freeSlot == nullptr) {
+                freeSlot = &cache;
+            }
+        }
+        if (freeSlot != nullptr) {
+            freeSlot->owner = this;
+            freeSlot->count = 0;
+        }
+        return freeSlot;
+    }
+
+    void detachThreadCache() {
+        if (threadTableDestroyed()) {
+            return;
+        }
+        for (auto &cache : threadTable().caches) {
+            if (cache.owner == this) {
+                drain(&cache, cache.count);
+                cache.owner = nullptr;
+            }
+        }
+    }
+
+    bool refill(ThreadCache *cache) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (cache->count < POOL_TLS_BATCH && freeList_ != nullptr) {
+            void *block = freeList_;
+            freeList_ = *static_cast<void **>(block);
+            freeCount_--;
+            cache->blocks[cache->count++] = block;
+        }
+        return cache->count > 0;
+    }
+
+    void drain(ThreadCache *cache, size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (count-- > 0 && cache->count > 0) {
+            void *block = cache->blocks[--cache->count];
+            *static_cast<void **>(block) = freeList_;
+            freeList_ = block;
+            freeCount_++;
+        }
+    }
+
+    void *popShared() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        void *block = freeList_;
+        if (block != nullptr) {
+            freeList_ = *static_cast<void **>(block);
+            freeCount_--;
+        }
+        return block;
+    }
+
+    void pushShared(void *block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        *static_cast<void **>(block) = freeList_;
+        freeList_ = block;
+        freeCount_++;
+    }
+
+    void *handOut(void *block) {
+        checkPoison(block);
+        poison(block, POOL_POISON_ALLOC);
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        size_t used = inUse_.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t peak = peak_.load(std::memory_order_relaxed);
+        while (used > peak && !peak_.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+        }
+        return block;
+    }
+
+    static size_t roundBlockSize(size_t size) {
+        const size_t align = alignof(std::max_align_t);
+        size = size < sizeof(void *) ? sizeof(void *) : size;
+        return (size + align - 1) / align * align;
+    }
+
+    // Poison everything except the free-list link in the first word
+    void poison(void *block, int pattern) const {
+#ifdef POOL_POISON
+        memset(static_cast<unsigned char *>(block) + sizeof(void *), pattern,
+               blockSize_ - sizeof(void *));
+#else
+        (void)block;
+        (void)pattern;
+#endif
+    }
+
+    void checkPoison(const void *block) const {
+#ifdef POOL_POISON
+        const unsigned char *p = static_cast<const unsigned char *>(block);
+        for (size_t i = sizeof(void *); i < blockSize_; i++) {
+            if (p[i] != POOL_POISON_FREE) {
+                LOG_ERROR("SlabPool %s: block %p modified after free (offset %zu)", name_, block, i);
+                return;
+            }
+        }
+#else
+        (void)block;
+#endif
+    }
+
+    const char *name_;
+    const size_t blockSize_;
+    const size_t blockCount_;
+    unsigned char *slab_;
+
+    std::mutex mutex_;
+    void *freeList_;
+    size_t freeCount_;
+
+    std::atomic<uint64_t> allocations_;
+    std::atomic<uint64_t> frees_;
+    std::atomic<uint64_t> failures_;
+    std::atomic<size_t> inUse_;
+    std::atomic<size_t> peak_;
+};
+
+class MonotonicArena {
+public:
+    MonotonicArena(const char *name, size_t capacity)
+        : name_(name), capacity_(capacity),
+          buffer_(static_cast<unsigned char *>(::operator new(capacity))), used_(0), peak_(0),
+          allocations_(0), failures_(0), resets_(0) {
+        poison(0, capacity_);
+    }
+
+    ~MonotonicArena() {
+        ::operator delete(buffer_);
+    }
+
+    // Non-copyable
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    // Returns nullptr when the arena is full; memory is released by reset()
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t offset = (used_ + align - 1) & ~(align - 1);
+        if (offset + size > capacity_) {
+            failures_++;
+            return nullptr;
+        }
+        used_ = offset + size;
+        if (used_ > peak_) {
+            peak_ = used_;
+        }
+        allocations_++;
+        return buffer_ + offset;
+    }
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args) {
+        void *memory = allocate(sizeof(T), alignof(T));
+        return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Release everything at once (destructors are not run)
+    void reset() {
+        poison(0, used_);
+        used_ = 0;
+        resets_++;
+    }
+
+    size_t used() const {
+        return used_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    PoolStats stats() const {
+        PoolStats s;
+        s.allocations = allocations_;
+        s.frees = resets_;
+        s.failures = failures_;
+        s.inUse = used_;
+        s.peak = peak_;
+        return s;
+    }
+
+    void logStats() const {
+        LOG_INFO("Arena %-9s %zu B  alloc %llu  resets %llu  fail %llu  peak %zu B", name_,
+                 capacity_, static_cast<unsigned long long>(allocations_),
+                 static_cast<unsigned long long>(resets_),
+                 static_cast<unsigned long long>(failures_), peak_);
+    }
+
+private:
+    void poison(size_t from, size_t to) {
+#ifdef POOL_POISON
+        memset(buffer_ + from, POOL_POISON_FREE, to - from);
+#else
+        (void)from;
+        (void)to;
+#endif
+    }
+
+    const char *name_;
+    const size_t capacity_;
+    unsigned char *buffer_;
+    size_t used_;
+    size_t peak_;
+    uint64_t allocations_;
+    uint64_t failures_;
+    uint64_t resets_;
+};
+
+/**
+ * Mixin that routes class-level new/delete through a SlabPool, e.g. for
+ * pipeline messages, log records or coroutine promise types:
+ *
+ *   struct Record : PoolAllocated<Record> { ... };
+ *   PoolAllocated<Record>::setPool(&recordPool);
+ *
+ * Falls back to the global heap when no pool is set or the pool is exhausted.
+ */
+template <typename Derived>
+class PoolAllocated {
+public:
+    static void setPool(SlabPool *pool) {
+        pool_ = pool;
+    }
+
+    static void *operator new(size_t size) {
+        if (pool_ != nullptr && size <= pool_->blockSize()) {
+            void *block = pool_->allocate();
+            if (block != nullptr) {
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    static void operator delete(void *ptr) {
+        if (pool_ != nullptr && pool_->owns(ptr)) {
+            pool_->deallocate(ptr);
+        } else {
+            ::operator delete(ptr);
+        }
+    }
+
+private:
+    static inline SlabPool *pool_ = nullptr;
+};
+
+#endif  // MEMORY_POOL_H
@@ -0,0 +1,413 @@
+/**
+ * @file pipeline.h
+ * @brief Staged data pipeline: source -> transform stages -> sink
+ *
+ * Consecutive stages are connected by bounded lock-free SPSC queues. Each
+ * stage runs either on the event loop (pumped by poll() from mainLoop) or on
+ * its own thread. When a downstream queue is full the feeding stage holds its
+ * item and stops pulling input, so back-pressure propagates up to the source.
+ *
+ * Example:
+ *   Pipeline<Sample> pipeline(64);
+ *   pipeline.setSource("acquire", readSensor);
+ *   pipeline.addStage("filter", lowPass, StageMode::MODE_THREAD);
+ *   pipeline.setSink("export", writeOut);
+ *   pipeline.configure("filter:loop,export:thread:64");  // optional, 64 KiB stack
+ *   pipeline.start();
+ *   while (running) { pipeline.poll(); }
+ *   pipeline.stop();
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <limits.h>
+#include <pthread.h>
+
+#include "logger.h"
+#include "spsc_queue.h"
+#include "thread_stack.h"
+
+// Where a stage executes
+enum class StageMode {
+    MODE_LOOP = 0,   // pumped from the event loop via Pipeline::poll()
+    MODE_THREAD = 1  // dedicated worker thread
+};
+
+// Role of a stage within the chain
+enum class StageKind {
+    KIND_SOURCE = 0,
+    KIND_TRANSFORM = 1,
+    KIND_SINK = 2
+};
+
+// Point-in-time copy of a stage's counters
+struct StageMetrics {
+    uint64_t processed;       // items that left the stage function
+    uint64_t dropped;         // items rejected by the stage function
+    uint64_t stalls;          // push attempts refused by a full downstream queue
+    uint64_t latencyTotalNs;  // accumulated time spent inside the stage function
+    uint64_t latencyMaxNs;    // worst single invocation
+    size_t stackSize;         // worker stack bytes (0 for loop-mode stages)
+    size_t stackUsed;         // worker stack high-water mark in bytes
+};
+
+template <typename T>
+class Pipeline {
+public:
+    /**
+     * Stage callback. Semantics depend on the stage kind:
+     *   source:    fill @p item, return false when nothing is available
+     *   transform: modify @p item in place, return false to drop it
+     *   sink:      consume @p item, return false to count it as dropped
+     */
+    using StageFn = std::function<bool(T &)>;
+
+    explicit Pipeline(size_t queueCapacity, size_t loopBatch = 16)
+        : queueCapacity_(queueCapacity), loopBatch_(loopBatch), running_(false),
+          idleSleep_(std::chrono::microseconds(200)), stackSize_(0) {}
+
+    ~Pipeline() {
+        stop();
+    }
+
+    // Non-copyable
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Topology declaration (must be called before start())
+    void setSource(const char *name, StageFn fn, StageMode mode = StageMode::MODE_LOOP) {
+        stages_.insert(stages_.begin(),
+                       std::unique_ptr<Stage>(new Stage(name, StageKind::KIND_SOURCE, fn, mode)));
+    }
+
+    void addStage(const char *name, StageFn fn, StageMode mode = StageMode::MODE_LOOP) {
+        auto it = stages_.end();
+        if (!stages_.empty() && stages_.back()->kind == StageKind::KIND_SINK) {
+            --it;
+        }
+        stages_.insert(it, std::unique_ptr<Stage>(new Stage(name, StageKind::KIND_TRANSFORM, fn, mode)));
+    }
+
+    void setSink(const char *name, StageFn fn, StageMode mode = StageMode::MODE_LOOP) {
+        stages_.push_back(std::unique_ptr<Stage>(new Stage(name, StageKind::KIND_SINK, fn, mode)));
+    }
+
+    // Sleep used by worker threads when they have nothing to do
+    void setIdleSleep(std::chrono::microseconds idle) {
+        idleSleep_ = idle;
+    }
+
+    // Stack size for worker threads without their own (0 = ThreadStacks::defaultSize())
+    void setStackSize(size_t bytes) {
+        stackSize_ = bytes;
+    }
+
+    /**
+     * Override stage modes from a spec such as "filter:thread:64,export:loop",
+     * where the optional third field is the worker stack size in KiB.
+     * Unknown stage names or modes, stack sizes that are not a number or
+     * below PTHREAD_STACK_MIN, and stack sizes on loop stages are reported
+     * and ignored.
+     * @return false if any entry could not be applied
+     */
+    bool configure(const char *spec) {
+        if (spec == nullptr) {
+            return true;
+        }
+        if (running_) {
+            LOG_WARN("Pipeline: topology cannot change while running");
+            return false;
+        }
+
+        bool ok = true;
+        const char *cursor = spec;
+        while (*cursor != '\0') {
+            const char *end = strchr(cursor, ',');
+            size_t len = end ? static_cast<size_t>(end - cursor) : strlen(cursor);
+            const char *colon = static_cast<const char *>(memchr(cursor, ':', len));
+
+            if (colon == nullptr) {
+                LOG_WARN("Pipeline: malformed topology entry '%.*s'", static_cast<int>(len), cursor);
+                ok = false;
+            } else {
+                size_t nameLen = static_cast<size_t>(colon - cursor);
+                size_t modeLen = len - nameLen - 1;
+                const char *stackField =
+                    static_cast<const char *>(memchr(colon + 1, ':', modeLen));
+                if (stackField != nullptr) {
+                    modeLen = static_cast<size_t>(stackField - colon - 1);
+                }
+                Stage *stage = findStage(cursor, nameLen);
+                if (stage == nullptr) {
+                    LOG_WARN("Pipeline: unknown stage '%.*s'", static_cast<int>(nameLen), cursor);
+                    ok = false;
+                } else if (modeLen == 4 && strncmp(colon + 1, "loop", 4) == 0) {
+                    stage->mode = StageMode::MODE_LOOP;
+                    if (stackField != nullptr) {
+                        LOG_WARN("Pipeline: stack size ignored for loop stage %s", stage->name);
+                        ok = false;
+                    }
+                } else if (modeLen == 6 && strncmp(colon + 1, "thread", 6) == 0) {
+                    stage->mode = StageMode::MODE_THREAD;
+                    if (stackField != nullptr) {
+                        int fieldLen = static_cast<int>(cursor + len - stackField - 1);
+                        size_t stackSize = parseStackKiB(stackField + 1, static_cast<size_t>(fieldLen));
+                        if (stackSize == 0) {
+                            LOG_WARN("Pipeline: invalid stack size '%.*s' KiB for stage %s (minimum %zu KiB)",
+                                     fieldLen, stackField + 1, stage->name,
+                                     static_cast<size_t>(PTHREAD_STACK_MIN) / 1024);
+                            ok = false;
+                        } else {
+                            stage->stackSize = stackSize;
+                        }
+                    }
+                } else {
+                    LOG_WARN("Pipeline: unknown mode '%.*s' for stage %s", static_cast<int>(modeLen),
+                             colon + 1, stage->name);
+                    ok = false;
+                }
+            }
+
+            cursor += len;
+            if (*cursor == ',') {
+                cursor++;
+            }
+        }
+        return ok;
+    }
+
+    // Allocate queues and launch worker threads
+    bool start() {
+        if (running_) {
+            return true;
+        }
+        if (stages_.size() < 2 || stages_.front()->kind != StageKind::KIND_SOURCE ||
+            stages_.back()->kind != StageKind::KIND_SINK) {
+            LOG_ERROR("Pipeline: topology needs a source and a sink");
+            return false;
+        }
+
+        queues_.clear();
+        for (size_t i = 0; i + 1 < stages_.size(); i++) {
+            queues_.push_back(std::unique_ptr<SpscQueue<T>>(new SpscQueue<T>(queueCapacity_)));
+        }
+        for (size_t i = 0; i < stages_.size(); i++) {
+            stages_[i]->input = (i > 0) ? queues_[i - 1].get() : nullptr;
+            stages_[i]->output = (i < queues_.size()) ? queues_[i].get() : nullptr;
+        }
+
+        startTime_ = std::chrono::steady_clock::now();
+        running_ = true;
+        for (auto &stage : stages_) {
+            LOG_DEBUG("Pipeline: stage '%s' runs on %s", stage->name,
+                      stage->mode == StageMode::MODE_THREAD ? "own thread" : "event loop");
+            if (stage->mode == StageMode::MODE_THREAD) {
+                Stage *raw = stage.get();
+                size_t stackSize = stage->stackSize ? stage->stackSize
+                                   : stackSize_     ? stackSize_
+                                                    : ThreadStacks::defaultSize();
+                if (!stage->worker.start(stage->name, stackSize, [this, raw]() { workerLoop(raw); })) {
+                    stop();
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Stop worker threads (queued items are left in place)
+    void stop() {
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        for (auto &stage : stages_) {
+            if (stage->worker.joinable()) {
+                stage->worker.join();
+            }
+        }
+    }
+
+    /**
+     * Run loop-mode stages for one event-loop iteration. Stages are visited
+     * source-first so a fresh item can reach the sink within a single poll.
+     * @return number of items moved
+     */
+    size_t poll() {
+        size_t moved = 0;
+        for (auto &entry : stages_) {
+            Stage *stage = entry.get();
+            if (stage->mode != StageMode::MODE_LOOP) {
+                continue;
+            }
+            for (size_t n = 0; n < loopBatch_ && step(stage); n++) {
+                moved++;
+            }
+        }
+        return moved;
+    }
+
+    size_t stageCount() const {
+        return stages_.size();
+    }
+
+    StageMetrics metrics(size_t index) const {
+        const Stage &stage = *stages_[index];
+        StageMetrics snapshot;
+        snapshot.processed = stage.processed.load(std::memory_order_relaxed);
+        snapshot.dropped = stage.dropped.load(std::memory_order_relaxed);
+        snapshot.stalls = stage.stalls.load(std::memory_order_relaxed);
+        snapshot.latencyTotalNs = stage.latencyTotalNs.load(std::memory_order_relaxed);
+        snapshot.latencyMaxNs = stage.latencyMaxNs.load(std::memory_order_relaxed);
+        snapshot.stackSize = stage.worker.stackSize();
+        snapshot.stackUsed = stage.worker.stackUsed();
+        return snapshot;
+    }
+
+    const char *stageName(size_t index) const {
+        return stages_[index]->name;
+    }
+
+    // Log per-stage throughput, latency and back-pressure counters
+    void logMetrics() const {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime_).count();
+        if (elapsed <= 0.0) {
+            elapsed = 1e-9;
+        }
+        LOG_INFO("Pipeline metrics (%.1f s):", elapsed);
+        for (size_t i = 0; i < stages_.size(); i++) {
+            StageMetrics m = metrics(i);
+            double avgUs = m.processed ? (m.latencyTotalNs / 1000.0) / m.processed : 0.0;
+            LOG_INFO("  %-10s %-6s %8.1f items/s  avg %7.2f us  max %7.2f us  drop %llu  stall %llu  queue %zu"
+                     "  stack %zu/%zu KiB",
+                     stages_[i]->name, stages_[i]->mode == StageMode::MODE_THREAD ? "thread" : "loop",
+                     m.processed / elapsed, avgUs, m.latencyMaxNs / 1000.0,
+                     static_cast<unsigned long long>(m.dropped),
+                     static_cast<unsigned long long>(m.stalls),
+                     stages_[i]->input ? stages_[i]->input->size() : static_cast<size_t>(0),
+                     (m.stackUsed + 1023) / 1024, m.stackSize / 1024);
+        }
+    }
+
+private:
+    struct Stage {
+        Stage(const char *stageName, StageKind stageKind, StageFn stageFn, StageMode stageMode)
+            : name(stageName), kind(stageKind), mode(stageMode), fn(stageFn), input(nullptr),
+              output(nullptr), stackSize(0), hasPending(false), processed(0), dropped(0), stalls(0),
+              latencyTotalNs(0), latencyMaxNs(0) {}
+
+        const char *name;
+        StageKind kind;
+        StageMode mode;
+        StageFn fn;
+        SpscQueue<T> *input;
+        SpscQueue<T> *output;
+        size_t stackSize;  // 0 = pipeline default
+        StackThread worker;
+
+        // Item held back because the downstream queue was full
+        T pending;
+        bool hasPending;
+
+        std::atomic<uint64_t> processed;
+        std::atomic<uint64_t> dropped;
+        std::atomic<uint64_t> stalls;
+        std::atomic<uint64_t> latencyTotalNs;
+        std::atomic<uint64_t> latencyMaxNs;
+    };
+
+    Stage *findStage(const char *name, size_t len) {
+        for (auto &stage : stages_) {
+            if (strlen(stage->name) == len && strncmp(stage->name, name, len) == 0) {
+                return stage.get();
+            }
+        }
+        return nullptr;
+    }
+
+    // Stack size in bytes from a decimal KiB field, 0 if malformed or too small
+    static size_t parseStackKiB(const char *field, size_t len) {
+        if (len == 0 || len > 9 || strspn(field, "0123456789") < len) {
+            return 0;
+        }
+        char digits[10];
+        memcpy(digits, field, len);
+        digits[len] = '\0';
+        size_t bytes = strtoul(digits, nullptr, 10) * 1024;
+        return bytes < static_cast<size_t>(PTHREAD_STACK_MIN) ? 0 : bytes;
+    }
+
+    // Advance one item through a stage; returns false if it made no progress
+    bool step(Stage *stage) {
+        if (!stage->hasPending) {
+            T item;
+            if (stage->input != nullptr && !stage->input->tryPop(item)) {
+                return false;
+            }
+
+            auto begin = std::chrono::steady_clock::now();
+            bool keep = stage->fn(item);
+            uint64_t ns = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin)
+                    .count());
+
+            if (stage->kind == StageKind::KIND_SOURCE && !keep) {
+                return false;  // nothing produced
+            }
+
+            stage->latencyTotalNs.fetch_add(ns, std::memory_order_relaxed);
+            uint64_t prevMax = stage->latencyMaxNs.load(std::memory_order_relaxed);
+            while (ns > prevMax &&
+                   !stage->latencyMaxNs.compare_exchange_weak(prevMax, ns, std::memory_order_relaxed)) {
+            }
+
+            if (!keep) {
+                stage->dropped.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            stage->processed.fetch_add(1, std::memory_order_relaxed);
+            if (stage->output == nullptr) {
+                return true;  // sink consumed the item
+            }
+            stage->pending = item;
+            stage->hasPending = true;
+        }
+
+        if (!stage->output->tryPush(stage->pending)) {
+            stage->stalls.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        stage->hasPending = false;
+        return true;
+    }
+
+    void workerLoop(Stage *stage) {
+        while (running_.load(std::memory_order_acquire)) {
+            if (!step(stage)) {
+                std::this_thread::sleep_for(idleSleep_);
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Stage>> stages_;
+    std::vector<std::unique_ptr<SpscQueue<T>>> queues_;
+    size_t queueCapacity_;
+    size_t loopBatch_;
+    std::atomic<bool> running_;
+    std::chrono::microseconds idleSleep_;
+    size_t stackSize_;
+    std::chrono::steady_clock::time_point startTime_;
+};
+
+#endif  // PIPELINE_H
@@ -0,0 +1,88 @@
+/**
+ * @file spsc_queue.h
+ * @brief Bounded lock-free single-producer/single-consumer ring buffer
+ *
+ * One thread may call tryPush() and one (possibly different) thread may call
+ * tryPop() concurrently without locks. Capacity is rounded up to a power of
+ * two and the storage is allocated once in the constructor.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Size of a cache line on the supported targets (keeps indices apart)
+#define SPSC_CACHE_LINE 64
+
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : capacity_(roundUpPow2(capacity)), mask_(capacity_ - 1),
+          buffer_(new T[capacity_]), head_(0), tail_(0), cachedHead_(0), cachedTail_(0) {}
+
+    // Non-copyable
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side: returns false if the queue is full
+    bool tryPush(const T &item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ >= capacity_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ >= capacity_) {
+                return false;
+            }
+        }
+        buffer_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: returns false if the queue is empty
+    bool tryPop(T &item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) {
+                return false;
+            }
+        }
+        item = buffer_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate number of queued items (exact when both sides are idle)
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    static size_t roundUpPow2(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> buffer_;
+
+    // Each index and each side's cached copy lives on its own cache line
+    alignas(SPSC_CACHE_LINE) std::atomic<size_t> head_;  // advanced by consumer
+    alignas(SPSC_CACHE_LINE) std::atomic<size_t> tail_;  // advanced by producer
+    alignas(SPSC_CACHE_LINE) size_t cachedHead_;  // producer's copy of head_
+    alignas(SPSC_CACHE_LINE) size_t cachedTail_;  // consumer's copy of tail_
+};
+
+#endif  // SPSC_QUEUE_H
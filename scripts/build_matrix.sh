@@ -0,0 +1,208 @@
+#!/bin/bash
+# ============================================================================
+# Build Matrix - Parallel Multi-Architecture Build and Test Driver
+# ============================================================================
+# Builds every architecture x mode combination concurrently. Each build goes
+# to its own build/<arch>/<variant>/ directory and only the binary inside it
+# is requested, so builds never share an output path and nothing is cleaned.
+# Host binaries are smoke-tested with --version and a short --bench run.
+#
+# Usage: scripts/build_matrix.sh [-j jobs] [-a "archs"] [-m "modes"] [-s|-S] [VAR=value ...]
+#   -j  concurrent builds (default: nproc)
+#   -a  architectures (default: host armhf arm64 armel riscv64 amd64 i386)
+#   -m  build modes (default: debug release)
+#   -s  diff each binary's sections/symbols against baselines/size/
+#       (scripts/size_track.sh; SIZE_TOLERANCE=<pct> fails on growth)
+#   -S  record each binary as its size baseline instead
+#   VAR=value arguments are passed to every make call (e.g. LTO=1 BOARD=rpi3)
+#
+# Environment:
+#   MAKE_JOBS       parallel jobs inside each make (default: 1)
+#   REQUIRED_ARCHS  architectures that fail instead of being skipped when
+#                   their compiler is missing (default: host armhf, the
+#                   Makefile's default target)
+#
+# With ccache in use (make CCACHE=auto|1), its statistics are reset first and
+# the hit rate of the run is printed at the end.
+#
+# Exits non-zero if any available combination fails; optional architectures
+# without an installed compiler are reported as skipped.
+# ============================================================================
+
+cd "$(dirname "$0")/.." || exit 1
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+JOBS=$(nproc)
+ARCHS="host armhf arm64 armel riscv64 amd64 i386"
+MODES="debug release"
+MAKE_JOBS="${MAKE_JOBS:-1}"
+REQUIRED_ARCHS="${REQUIRED_ARCHS:-host armhf}"
+SIZE_TRACK=""
+
+while getopts "j:a:m:sSh" opt; do
+    case $opt in
+        j) JOBS="$OPTARG" ;;
+        a) ARCHS="$OPTARG" ;;
+        m) MODES="$OPTARG" ;;
+        s) SIZE_TRACK=diff ;;
+        S) SIZE_TRACK=update ;;
+        *) sed -n '2,30p' "$0"; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+MAKE_VARS=("$@")
+
+# armhf uses the Makefile's default target toolchain (build/target/...)
+declare -A ARCH_COMPILERS=(
+    ["host"]="g++"
+    ["armhf"]="arm-linux-gnueabihf-g++"
+    ["arm64"]="aarch64-linux-gnu-g++"
+    ["armel"]="arm-linux-gnueabi-g++"
+    ["riscv64"]="riscv64-linux-gnu-g++"
+    ["amd64"]="x86_64-linux-gnu-g++"
+    ["i386"]="i686-linux-gnu-g++"
+)
+
+RESULTS_DIR="build/matrix"
+rm -rf "$RESULTS_DIR"
+mkdir -p "$RESULTS_DIR"
+
+# Make arguments and output binary for one arch/mode
+make_args() {
+    local arch=$1 mode=$2
+    case $arch in
+        host)  echo "BUILD_MODE=$mode" ;;
+        armhf) echo "BUILD_MODE=$mode" ;;
+        *)     echo "BUILD_MODE=$mode CROSS_ARCH=$arch CPP=${ARCH_COMPILERS[$arch]}" ;;
+    esac
+}
+
+binary_path() {
+    local arch=$1 mode=$2 dir bin
+    case $arch in
+        host)  dir=HOST_OUT_DIR;   bin=HOST_BINARY ;;
+        armhf) dir=TARGET_OUT_DIR; bin=TARGET_BINARY ;;
+        *)     dir=CROSS_OUT_DIR;  bin=CROSS_BINARY ;;
+    esac
+    # shellcheck disable=SC2046
+    echo "$(make -s $(make_args "$arch" "$mode") "${MAKE_VARS[@]}" print-$dir)/$(make -s $(make_args "$arch" "$mode") "${MAKE_VARS[@]}" print-$bin)"
+}
+
+# Build (and for the host, run) one combination; writes <name>.result
+# as "<status> <seconds> <bytes>"
+run_one() {
+    local arch=$1 mode=$2 name="$1-$2" binary status=FAIL size=0 start end
+    local log="$RESULTS_DIR/$name.log"
+    binary=$(binary_path "$arch" "$mode")
+    start=$(date +%s%N)
+    # shellcheck disable=SC2046
+    if make -j"$MAKE_JOBS" $(make_args "$arch" "$mode") "${MAKE_VARS[@]}" "$binary" > "$log" 2>&1; then
+        status=PASS
+        size=$(stat -c %s "$binary")
+        if [ "$arch" = host ]; then
+            if ! { "$binary" --version &&
+                   "$binary" --bench=100 --bench-reps=1 --bench-warmup=0; } >> "$log" 2>&1; then
+                status=FAIL
+            fi
+        fi
+        # Size baselines are named <dir>-<variant> after the build directory
+        # (build/target/ for armhf, as make size-diff names them)
+        if [ -n "$SIZE_TRACK" ] && [ $status = PASS ]; then
+            local prefix="${ARCH_COMPILERS[$arch]%g++}"
+            [ "$arch" = host ] && prefix=""
+            local label
+            label="$(basename "$(dirname "$(dirname "$binary")")")-$(basename "$(dirname "$binary")")"
+            # shellcheck disable=SC2046
+            if ! TOOL_PREFIX="$prefix" scripts/size_track.sh $([ "$SIZE_TRACK" = update ] && echo -u) \
+                    "$label" "$binary" > "$RESULTS_DIR/$name.size" 2>&1; then
+                status=FAIL
+                echo "Size tolerance exceeded, see $RESULTS_DIR/$name.size" >> "$log"
+            fi
+        fi
+    fi
+    end=$(date +%s%N)
+    echo "$status $(( (end - start) / 1000000 )) $size" > "$RESULTS_DIR/$name.result"
+}
+
+echo "============================================="
+echo "  Build Matrix ($JOBS jobs)"
+echo "============================================="
+
+CCACHE_LAUNCHER=$(make -s "${MAKE_VARS[@]}" print-COMPILER_LAUNCHER)
+[ -n "$CCACHE_LAUNCHER" ] && make -s "${MAKE_VARS[@]}" ccache-zero
+
+matrix_start=$(date +%s%N)
+for arch in $ARCHS; do
+    if [ -z "${ARCH_COMPILERS[$arch]}" ]; then
+        echo -e "${RED}[FAIL]${NC} Unknown architecture: $arch"
+        exit 2
+    fi
+    for mode in $MODES; do
+        if ! command -v "${ARCH_COMPILERS[$arch]}" &> /dev/null; then
+            if [[ " $REQUIRED_ARCHS " = *" $arch "* ]]; then
+                echo "${ARCH_COMPILERS[$arch]} not installed ($arch is required)" > "$RESULTS_DIR/$arch-$mode.log"
+                echo "FAIL 0 0" > "$RESULTS_DIR/$arch-$mode.result"
+            else
+                echo "SKIP 0 0" > "$RESULTS_DIR/$arch-$mode.result"
+            fi
+            continue
+        fi
+        while [ "$(jobs -rp | wc -l)" -ge "$JOBS" ]; do
+            wait -n
+        done
+        run_one "$arch" "$mode" &
+    done
+done
+wait
+matrix_end=$(date +%s%N)
+
+# Summary: one row per arch, one column per mode
+PASSED=0
+FAILED=0
+SKIPPED=0
+printf "\n  %-9s" "arch"
+for mode in $MODES; do
+    printf " %-24s" "$mode"
+done
+echo ""
+for arch in $ARCHS; do
+    printf "  %-9s" "$arch"
+    for mode in $MODES; do
+        read -r status ms size < "$RESULTS_DIR/$arch-$mode.result"
+        case $status in
+            PASS) PASSED=$((PASSED + 1))
+                  cell=$(printf "%-4s %6.1fs %8d B" ok "$(awk -v m="$ms" 'BEGIN { print m / 1000 }')" "$size")
+                  printf " ${GREEN}%-24s${NC}" "$cell" ;;
+            FAIL) FAILED=$((FAILED + 1))
+                  printf " ${RED}%-24s${NC}" "FAIL ($RESULTS_DIR/$arch-$mode.log)" ;;
+            *)    SKIPPED=$((SKIPPED + 1))
+                  printf " ${YELLOW}%-24s${NC}" "skip (no compiler)" ;;
+        esac
+    done
+    echo ""
+done
+
+if [ -n "$SIZE_TRACK" ]; then
+    for arch in $ARCHS; do
+        for mode in $MODES; do
+            [ -f "$RESULTS_DIR/$arch-$mode.size" ] && { echo ""; cat "$RESULTS_DIR/$arch-$mode.size"; }
+        done
+    done
+fi
+
+echo ""
+echo "============================================="
+echo -e "  ${GREEN}Passed:${NC} $PASSED  ${RED}Failed:${NC} $FAILED  ${YELLOW}Skipped:${NC} $SKIPPED"
+if [ -n "$CCACHE_LAUNCHER" ]; then
+    echo "  ccache:"
+    make -s "${MAKE_VARS[@]}" ccache-stats | grep -iE 'hit|miss' | sed 's/^/    /'
+fi
+echo "  Wall time: $(awk -v n="$(( (matrix_end - matrix_start) / 1000000 ))" 'BEGIN { printf "%.1f", n / 1000 }')s"
+echo "============================================="
+
+[ $FAILED -eq 0 ]
@@ -0,0 +1,94 @@
+#!/bin/bash
+# ============================================================================
+# Compare Builds - Size and Benchmark Difference Between Two Binaries
+# ============================================================================
+# Usage: scripts/compare_builds.sh <base-label> <base.bin> <new-label> <new.bin>
+#
+# Prints section sizes (text/data/bss), startup time (mean of STARTUP_RUNS
+# runs of --version) and the --bench workload results of both binaries with
+# the relative change. The harness reports the median of its repetitions;
+# the binaries run BENCH_REPEAT times and the fastest median is kept.
+#
+# Environment:
+#   SIZE              size tool for the binaries' architecture (default: size)
+#   BENCH_RUNNER      command prefix to run the binaries (e.g. qemu-aarch64 -L ...)
+#   BENCH_ITERATIONS  iterations per batch for every benchmark (default: per benchmark)
+#   BENCH_REPEAT      runs per binary (default: 3)
+#   STARTUP_RUNS      process starts timed per binary (default: 20)
+# ============================================================================
+
+set -e
+
+SIZE="${SIZE:-size}"
+BENCH_REPEAT="${BENCH_REPEAT:-3}"
+STARTUP_RUNS="${STARTUP_RUNS:-20}"
+
+if [ $# -ne 4 ]; then
+    echo "Usage: $0 <base-label> <base.bin> <new-label> <new.bin>" >&2
+    exit 2
+fi
+
+BASE_LABEL="$1"
+BASE_BIN="$2"
+NEW_LABEL="$3"
+NEW_BIN="$4"
+
+for bin in "$BASE_BIN" "$NEW_BIN"; do
+    if [ ! -f "$bin" ]; then
+        echo "Missing binary: $bin" >&2
+        exit 1
+    fi
+done
+
+# Relative change of $2 against $1 in percent
+delta() {
+    awk -v a="$1" -v b="$2" 'BEGIN { if (a > 0) printf "%+.1f%%", (b - a) * 100 / a; else print "-" }'
+}
+
+# Mean wall time in microseconds to start, print the version and exit
+startup() {
+    local start end
+    start=$(date +%s%N)
+    for _ in $(seq "$STARTUP_RUNS"); do
+        $BENCH_RUNNER "$1" --version > /dev/null
+    done
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000 / STARTUP_RUNS ))
+}
+
+# Print "<name> <ns/op>" for each workload, best of BENCH_REPEAT runs
+bench() {
+    local arg="--bench"
+    [ -n "$BENCH_ITERATIONS" ] && arg="--bench=$BENCH_ITERATIONS"
+    for _ in $(seq "$BENCH_REPEAT"); do
+        $BENCH_RUNNER "$1" "$arg" | awk '$1 == "bench" { print $2, $3 }'
+    done | sort -k1,1 -k2,2g | awk '!seen[$1]++'
+}
+
+echo "============================================="
+echo "  $BASE_LABEL vs $NEW_LABEL"
+echo "============================================="
+
+read -r base_text base_data base_bss _ < <("$SIZE" "$BASE_BIN" | tail -1)
+read -r new_text new_data new_bss _ < <("$SIZE" "$NEW_BIN" | tail -1)
+base_file=$(stat -c %s "$BASE_BIN")
+new_file=$(stat -c %s "$NEW_BIN")
+
+printf "  %-14s %12s %12s %8s\n" "size (bytes)" "$BASE_LABEL" "$NEW_LABEL" "change"
+printf "  %-14s %12d %12d %8s\n" "text" "$base_text" "$new_text" "$(delta "$base_text" "$new_text")"
+printf "  %-14s %12d %12d %8s\n" "data" "$base_data" "$new_data" "$(delta "$base_data" "$new_data")"
+printf "  %-14s %12d %12d %8s\n" "bss" "$base_bss" "$new_bss" "$(delta "$base_bss" "$new_bss")"
+printf "  %-14s %12d %12d %8s\n" "file" "$base_file" "$new_file" "$(delta "$base_file" "$new_file")"
+echo ""
+
+base_start=$(startup "$BASE_BIN")
+new_start=$(startup "$NEW_BIN")
+printf "  %-14s %12s %12s %8s\n" "startup (us)" "$BASE_LABEL" "$NEW_LABEL" "change"
+printf "  %-14s %12d %12d %8s\n" "--version" "$base_start" "$new_start" "$(delta "$base_start" "$new_start")"
+echo ""
+
+printf "  %-14s %12s %12s %8s\n" "bench (ns/op)" "$BASE_LABEL" "$NEW_LABEL" "change"
+join <(bench "$BASE_BIN") <(bench "$NEW_BIN") | while read -r name base new; do
+    printf "  %-14s %12.1f %12.1f %8s\n" "$name" "$base" "$new" "$(delta "$base" "$new")"
+done
+echo "============================================="
@@ -0,0 +1,152 @@
+#!/bin/bash
+# ============================================================================
+# Fleet Deploy - Parallel Deployment to Every Target in an Inventory
+# ============================================================================
+# Usage: scripts/deploy_fleet.sh [-j jobs] [-r retries] [-b bindir] <inventory>
+#        (or ./deploy.sh --fleet ...)
+#   -j  concurrent deployments (default: 8)
+#   -r  retries per target after a failed attempt (default: 2)
+#   -b  directory holding the built binaries (default: repository root)
+#
+# The inventory has one target per line, '#' starts a comment:
+#
+#   # ip[:port]       arch     dest dir        credentials
+#   192.168.1.101     armhf    /home/debian    BENCH_LOGIN
+#   192.168.1.102     arm64    /opt/firmware   BENCH_LOGIN
+#   local             host     /tmp/target1    -
+#
+# The binary is picked by arch as the Makefile names it: firmware.bin for
+# armhf (the default target), program.bin for host and firmware_<arch>.bin
+# otherwise. Credentials are the name of an environment variable holding
+# "user:password", so passwords stay out of the inventory ("-" for local
+# targets). Each target runs ./deploy.sh without gdbserver; retries back off
+# 1, 2, 4... seconds. Logs go to build/fleet/<n>-<ip>.log.
+#
+# Exits non-zero if any target failed after all retries.
+# ============================================================================
+
+CALLER_DIR="$PWD"
+cd "$(dirname "$0")/.." || exit 1
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+NC='\033[0m'
+
+JOBS=8
+RETRIES=2
+BIN_DIR="."
+
+while getopts "j:r:b:h" opt; do
+    case $opt in
+        j) JOBS="$OPTARG" ;;
+        r) RETRIES="$OPTARG" ;;
+        b) BIN_DIR="$OPTARG"; [[ $BIN_DIR = /* ]] || BIN_DIR="$CALLER_DIR/$BIN_DIR" ;;
+        *) sed -n '2,27p' "$0"; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+INVENTORY="$1"
+[[ $INVENTORY = /* ]] || INVENTORY="$CALLER_DIR/$INVENTORY"
+if [ $# -ne 1 ] || [ ! -f "$INVENTORY" ]; then
+    echo "Usage: $0 [-j jobs] [-r retries] [-b bindir] <inventory>" >&2
+    exit 2
+fi
+
+RESULTS_DIR="build/fleet"
+rm -rf "$RESULTS_DIR"
+mkdir -p "$RESULTS_DIR"
+
+binary_for() {
+    case $1 in
+        armhf) echo "$BIN_DIR/firmware.bin" ;;
+        host)  echo "$BIN_DIR/program.bin" ;;
+        *)     echo "$BIN_DIR/firmware_$1.bin" ;;
+    esac
+}
+
+# Deploy one target with retries; writes <n>.result as
+# "<status> <attempts> <ms> <method> <bytes-sent>"
+deploy_one() {
+    local n=$1 ip=$2 arch=$3 dest=$4 creds=$5
+    local log="$RESULTS_DIR/$n-${ip//[:\/]/_}.log" binary login user pass
+    local attempt=0 status=FAIL start end summary method="-" sent=0
+    binary=$(binary_for "$arch")
+    start=$(date +%s%N)
+    if [ "$creds" = - ]; then
+        user=-; pass=-
+    else
+        login="${!creds}"
+        user="${login%%:*}"; pass="${login#*:}"
+    fi
+    if [ ! -f "$binary" ]; then
+        echo "Binary $binary not found (build $arch first)" > "$log"
+    elif [ "$creds" != - ] && [ -z "$login" ]; then
+        echo "Credentials variable $creds is not set" > "$log"
+    else
+        : > "$log"
+        while [ $attempt -le "$RETRIES" ]; do
+            [ $attempt -gt 0 ] && sleep $((1 << (attempt - 1)))
+            attempt=$((attempt + 1))
+            echo "=== attempt $attempt" >> "$log"
+            if DEPLOY_GDBSERVER=0 ./deploy.sh "$ip" 0 "$binary" "$dest" "$user" "$pass" >> "$log" 2>&1; then
+                status=PASS
+                break
+            fi
+        done
+        # "Deployed <name>: <method>, <sent> of <size> bytes sent, ..."
+        summary=$(sed -n 's/.*Deployed [^:]*: \([a-z]*\), \([0-9]*\) of.*/\1 \2/p' "$log" | tail -1)
+        [ -n "$summary" ] && read -r method sent <<< "$summary"
+    fi
+    end=$(date +%s%N)
+    echo "$status $attempt $(( (end - start) / 1000000 )) $method $sent" > "$RESULTS_DIR/$n.result"
+}
+
+echo "============================================="
+echo "  Fleet Deploy ($JOBS jobs, $RETRIES retries)"
+echo "============================================="
+
+TARGETS=()
+fleet_start=$(date +%s%N)
+n=0
+while read -r ip arch dest creds _; do
+    case "$ip" in ''|\#*) continue ;; esac
+    if [ -z "$creds" ]; then
+        echo -e "${RED}[FAIL]${NC} Incomplete inventory line: $ip $arch $dest" >&2
+        exit 2
+    fi
+    n=$((n + 1))
+    TARGETS+=("$n $ip $arch $dest")
+    while [ "$(jobs -rp | wc -l)" -ge "$JOBS" ]; do
+        wait -n
+    done
+    deploy_one "$n" "$ip" "$arch" "$dest" "$creds" &
+done < "$INVENTORY"
+wait
+fleet_end=$(date +%s%N)
+
+PASSED=0
+FAILED=0
+printf "\n  %-22s %-8s %-6s %8s %8s %-7s %10s\n" "target" "arch" "status" "attempts" "time" "method" "sent"
+for target in "${TARGETS[@]}"; do
+    read -r n ip arch dest <<< "$target"
+    read -r status attempts ms method sent < "$RESULTS_DIR/$n.result"
+    time=$(awk -v m="$ms" 'BEGIN { printf "%.1fs", m / 1000 }')
+    if [ "$status" = PASS ]; then
+        PASSED=$((PASSED + 1))
+        color=$GREEN; cell=ok
+    else
+        FAILED=$((FAILED + 1))
+        color=$RED; cell=FAIL
+    fi
+    printf "  %-22s %-8s ${color}%-6s${NC} %8s %8s %-7s %10s\n" "$ip:$dest" "$arch" "$cell" "$attempts" "$time" "$method" "$sent B"
+done
+
+echo ""
+echo "============================================="
+echo -e "  ${GREEN}Deployed:${NC} $PASSED  ${RED}Failed:${NC} $FAILED  (logs: $RESULTS_DIR/)"
+echo "  Wall time: $(awk -v n="$(( (fleet_end - fleet_start) / 1000000 ))" 'BEGIN { printf "%.1f", n / 1000 }')s"
+echo "============================================="
+
+[ $FAILED -eq 0 ]
@@ -0,0 +1,116 @@
+#!/bin/bash
+# ============================================================================
+# Instruction-Count Benchmarks - Deterministic Cost per Benchmark Case
+# ============================================================================
+# Usage: scripts/icount_bench.sh <binary>
+#
+# Counts retired instructions per operation for every --bench case instead of
+# timing it, so results do not depend on machine load or emulation speed.
+# Host binaries run under cachegrind, which also simulates D1 and last-level
+# cache misses; cross binaries run under qemu-user with its TCG instruction
+# counting plugin (libinsn.so from qemu's tests/plugin directory).
+#
+# Each case runs as a single batch (no warmup) with ICOUNT_LO and ICOUNT_HI
+# iterations and the difference is divided by the iteration difference,
+# which cancels startup and shutdown.
+#
+# Environment:
+#   RUNNER            qemu-user command (e.g. qemu-arm -L /usr/arm-linux-gnueabihf);
+#                     empty selects cachegrind on the host
+#   QEMU_INSN_PLUGIN  path to libinsn.so (required with RUNNER)
+#   ICOUNT_LO/HI      iteration counts (default: 1000 / 3000)
+#   ARCH, MODE        labels stored in the results (default: host / release)
+#   OUTPUT            JSON results file (default: stdout table only)
+# ============================================================================
+
+set -e
+
+ICOUNT_LO="${ICOUNT_LO:-1000}"
+ICOUNT_HI="${ICOUNT_HI:-3000}"
+ARCH="${ARCH:-host}"
+MODE="${MODE:-release}"
+
+if [ $# -ne 1 ] || [ ! -f "$1" ]; then
+    echo "Usage: $0 <binary>" >&2
+    exit 2
+fi
+BINARY="$1"
+
+if [ -z "$RUNNER" ]; then
+    TOOL=cachegrind
+    if ! command -v valgrind &> /dev/null; then
+        echo "valgrind not found (apt install valgrind)" >&2
+        exit 1
+    fi
+else
+    TOOL=qemu-insn
+    if [ ! -f "$QEMU_INSN_PLUGIN" ]; then
+        echo "QEMU_INSN_PLUGIN not set or missing: '$QEMU_INSN_PLUGIN'" >&2
+        echo "Build it from qemu's source tree: make -C build plugins (tests/plugin/libinsn.so)" >&2
+        exit 1
+    fi
+fi
+
+LOG=$(mktemp)
+trap 'rm -f "$LOG"' EXIT
+
+# Print "<instructions> <d1-misses> <ll-misses>" for one case and iteration count
+measure() {
+    local name=$1 iterations=$2
+    if [ "$TOOL" = cachegrind ]; then
+        valgrind --tool=cachegrind --cache-sim=yes --cachegrind-out-file=/dev/null \
+            "$BINARY" --bench="$iterations" --bench-filter="$name" --bench-reps=1 --bench-warmup=0 \
+            > /dev/null 2> "$LOG"
+        awk '$2 == "I" && $3 == "refs:" { gsub(",", "", $4); i = $4 }
+             $2 == "D1" && $3 == "misses:" { gsub(",", "", $4); d = $4 }
+             $2 == "LL" && $3 == "misses:" { gsub(",", "", $4); l = $4 }
+             END { print i + 0, d + 0, l + 0 }' "$LOG"
+    else
+        # shellcheck disable=SC2086
+        $RUNNER -plugin "$QEMU_INSN_PLUGIN" -d plugin -D "$LOG" \
+            "$BINARY" --bench="$iterations" --bench-filter="$name" --bench-reps=1 --bench-warmup=0 \
+            > /dev/null
+        awk '/total insns:/ { total = $NF }
+             /^(cpu [0-9]+ )?insns:/ { sum += $NF }
+             END { print (total ? total : sum) + 0, 0, 0 }' "$LOG"
+    fi
+}
+
+# Benchmark case names, as printed by a short run
+CASES=$(${RUNNER} "$BINARY" --bench=1 --bench-reps=1 --bench-warmup=0 | awk '$1 == "bench" { print $2 }')
+
+echo "============================================="
+echo "  $ARCH $MODE: instructions per op ($TOOL)"
+echo "============================================="
+printf "  %-14s %14s %12s %12s\n" "case" "insn/op" "D1 miss/op" "LL miss/op"
+
+RESULTS=()
+for name in $CASES; do
+    read -r lo_i lo_d lo_l < <(measure "$name" "$ICOUNT_LO")
+    read -r hi_i hi_d hi_l < <(measure "$name" "$ICOUNT_HI")
+    read -r insn d1 ll < <(awk -v n=$((ICOUNT_HI - ICOUNT_LO)) \
+        -v i=$((hi_i - lo_i)) -v d=$((hi_d - lo_d)) -v l=$((hi_l - lo_l)) \
+        'BEGIN { printf "%.1f %.3f %.3f\n", i / n, d / n, l / n }')
+    if [ "$TOOL" = cachegrind ]; then
+        printf "  %-14s %14.1f %12.3f %12.3f\n" "$name" "$insn" "$d1" "$ll"
+        RESULTS+=("{\"name\": \"$name\", \"instructions_per_op\": $insn, \"d1_misses_per_op\": $d1, \"ll_misses_per_op\": $ll}")
+    else
+        printf "  %-14s %14.1f %12s %12s\n" "$name" "$insn" "-" "-"
+        RESULTS+=("{\"name\": \"$name\", \"instructions_per_op\": $insn}")
+    fi
+done
+echo "============================================="
+
+if [ -n "$OUTPUT" ]; then
+    mkdir -p "$(dirname "$OUTPUT")"
+    {
+        echo "{\"arch\": \"$ARCH\", \"mode\": \"$MODE\", \"tool\": \"$TOOL\", \"results\": ["
+        for i in "${!RESULTS[@]}"; do
+            sep=","
+            [ "$i" -eq $((${#RESULTS[@]} - 1)) ] && sep=""
+            echo "  ${RESULTS[$i]}$sep"
+        done
+        echo "]}"
+    } > "$OUTPUT"
+    echo "Results: $OUTPUT"
+fi
@@ -0,0 +1,236 @@
+#!/bin/bash
+# ============================================================================
+# Performance Gate - Compare Benchmark Results Against a Stored Baseline
+# ============================================================================
+# Usage: scripts/perf_gate.sh [-u] <binary>
+#   -u  record the current results as the new baseline instead of comparing
+#
+# Baselines live in $BASELINE_DIR/<arch>-<mode>.json, one result per line:
+#
+#   {"arch": "host", "mode": "release", "machine": "...", "compiler": "...", "results": [
+#     {"name": "logger/enabled", "instructions_per_op": 812.0, "ns_per_op": 1680.7},
+#     ...
+#   ]}
+#
+# Instructions per op come from scripts/icount_bench.sh (cachegrind, or the
+# qemu plugin with RUNNER) and are compared on any machine. Wall time (the
+# harness median) is only compared when the baseline was recorded on the
+# same machine and the binary runs natively, since emulated or foreign
+# timings say nothing about a regression. A metric regresses when it grows
+# by more than its tolerance and by more than its absolute floor. Slower
+# wall time only fails the gate with PERF_TIME=1 (a quiet, dedicated
+# machine); otherwise it is reported as "slower". A case that disappeared
+# from the binary also fails the gate (when BENCH_JSON comes from a run with
+# --bench-filter, only the cases that filter selects count), and so does a missing instruction
+# count (no counter here, or a baseline recorded without one) unless
+# PERF_ICOUNT=0 asks for a wall-time-only comparison.
+#
+# Environment:
+#   RUNNER, QEMU_INSN_PLUGIN  as for scripts/icount_bench.sh
+#   ARCH, MODE                baseline selection (default: host / release)
+#   BASELINE_DIR              baseline directory (default: <repo>/baselines/perf)
+#   ICOUNT_TOLERANCE          allowed instruction growth in % (default: 2)
+#   TIME_TOLERANCE            allowed wall-time growth in % (default: 20)
+#   TIME_MIN_NS               ignore wall-time growth below this (default: 5)
+#   PERF_TIME                 wall time: auto (native runs, warn only) | 0 (skip)
+#                             | 1 (also under RUNNER, regressions fail)
+#   COMPILER                  compiler version stored with the baseline
+#   BENCH_JSON                harness results measured elsewhere (a board, see
+#                             scripts/remote_bench.sh) used for wall time
+#                             instead of running <binary>
+#   MACHINE                   machine BENCH_JSON was measured on (default:
+#                             this one, "<uname -m> <cpu model name>")
+#   PERF_ICOUNT               1 (instruction counts required) | 0 (skipped;
+#                             wall time only) (default: 1)
+#
+# Exits 1 on a regression or missing instruction counts, 0 when everything
+# is within tolerance or no baseline exists yet.
+# ============================================================================
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+ARCH="${ARCH:-host}"
+MODE="${MODE:-release}"
+BASELINE_DIR="${BASELINE_DIR:-$(dirname "$SCRIPT_DIR")/baselines/perf}"
+ICOUNT_TOLERANCE="${ICOUNT_TOLERANCE:-2}"
+TIME_TOLERANCE="${TIME_TOLERANCE:-20}"
+TIME_MIN_NS="${TIME_MIN_NS:-5}"
+PERF_TIME="${PERF_TIME:-auto}"
+PERF_ICOUNT="${PERF_ICOUNT:-1}"
+COMPILER="${COMPILER:-unknown}"
+
+UPDATE=0
+while getopts "uh" opt; do
+    case $opt in
+        u) UPDATE=1 ;;
+        *) sed -n '2,48p' "$0"; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 1 ] || [ ! -f "$1" ]; then
+    echo "Usage: $0 [-u] <binary>" >&2
+    exit 2
+fi
+BINARY="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"
+BASELINE="$BASELINE_DIR/$ARCH-$MODE.json"
+MACHINE="${MACHINE:-$(uname -m) $(awk -F': ' '/^model name/ { print $2; exit }' /proc/cpuinfo)}"
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Instruction counts, when a counting tool exists for this binary
+if [ "$PERF_ICOUNT" = 0 ]; then
+    :
+elif { [ -z "$RUNNER" ] && command -v valgrind &> /dev/null; } ||
+   { [ -n "$RUNNER" ] && [ -f "$QEMU_INSN_PLUGIN" ]; }; then
+    echo "==> Counting instructions..."
+    RUNNER="$RUNNER" QEMU_INSN_PLUGIN="$QEMU_INSN_PLUGIN" ARCH="$ARCH" MODE="$MODE" \
+        OUTPUT="$WORK/icount.json" "$SCRIPT_DIR/icount_bench.sh" "$BINARY" > /dev/null
+else
+    echo -e "${RED}[FAIL]${NC} No instruction counter (valgrind, or RUNNER with QEMU_INSN_PLUGIN)"
+    echo "  Instruction counts are the gate's primary metric; PERF_ICOUNT=0 compares wall time only"
+    exit 1
+fi
+
+# Wall time, natively unless forced; results from a board are native
+if [ -n "$BENCH_JSON" ] && [ "$PERF_TIME" != 0 ]; then
+    cp "$BENCH_JSON" "$WORK/time.json"
+elif [ "$PERF_TIME" = 1 ] || { [ "$PERF_TIME" = auto ] && [ -z "$RUNNER" ]; }; then
+    echo "==> Timing benchmarks..."
+    # shellcheck disable=SC2086
+    $RUNNER "$BINARY" --bench --bench-json="$WORK/time.json" > /dev/null 2>&1
+fi
+
+# Merge both result files into "<name> <insn/op|-> <ns/op|->" lines
+touch "$WORK/icount.json" "$WORK/time.json"
+awk 'function value(key,    s) {
+         if (!match($0, "\"" key "\": [0-9.]+")) return "-"
+         s = substr($0, RSTART, RLENGTH); sub(/.*: /, "", s); return s
+     }
+     match($0, /"name": "[^"]*"/) {
+         name = substr($0, RSTART + 9, RLENGTH - 10)
+         if (!(name in seen)) { seen[name] = 1; order[++count] = name; insn[name] = "-"; ns[name] = "-" }
+         if (FILENAME ~ /icount/) insn[name] = value("instructions_per_op"); else ns[name] = value("ns_per_op")
+     }
+     END { for (i = 1; i <= count; i++) print order[i], insn[order[i]], ns[order[i]] }' \
+    "$WORK/icount.json" "$WORK/time.json" | sort > "$WORK/current"
+
+# A filtered run (--bench-filter, recorded in its context) only has the
+# cases the filter selects
+FILTER=$(sed -n 's/.*"filter": "\([^"]*\)".*/\1/p' "$WORK/time.json" | head -1)
+
+if [ ! -s "$WORK/current" ]; then
+    echo -e "${RED}[FAIL]${NC} No benchmark results to compare"
+    exit 1
+fi
+
+if [ $UPDATE -eq 1 ]; then
+    mkdir -p "$BASELINE_DIR"
+    {
+        echo "{\"arch\": \"$ARCH\", \"mode\": \"$MODE\", \"machine\": \"$MACHINE\", \"compiler\": \"$COMPILER\", \"results\": ["
+        awk '{ line = "  {\"name\": \"" $1 "\""
+               if ($2 != "-") line = line ", \"instructions_per_op\": " $2
+               if ($3 != "-") line = line ", \"ns_per_op\": " $3
+               lines[NR] = line "}" }
+             END { for (i = 1; i <= NR; i++) print lines[i] (i < NR ? "," : "") }' "$WORK/current"
+        echo "]}"
+    } > "$BASELINE"
+    echo -e "${GREEN}[OK]${NC} Baseline written: $BASELINE ($(wc -l < "$WORK/current") cases)"
+    exit 0
+fi
+
+if [ ! -f "$BASELINE" ]; then
+    echo -e "${YELLOW}[WARN]${NC} No baseline $BASELINE; record one with $0 -u (make perf-baseline)"
+    exit 0
+fi
+
+if [ "$PERF_ICOUNT" != 0 ] && ! grep -q '"instructions_per_op"' "$BASELINE"; then
+    echo -e "${RED}[FAIL]${NC} Baseline $BASELINE has no instruction counts"
+    echo "  It was recorded without valgrind or the qemu plugin. Re-record it where one is"
+    echo "  installed (make perf-baseline), or compare wall time only with PERF_ICOUNT=0"
+    exit 1
+fi
+
+# Wall time from another machine is not comparable
+BASE_MACHINE=$(sed -n 's/.*"machine": "\([^"]*\)".*/\1/p' "$BASELINE" | head -1)
+BASE_COMPILER=$(sed -n 's/.*"compiler": "\([^"]*\)".*/\1/p' "$BASELINE" | head -1)
+COMPARE_TIME=1
+if [ "$BASE_MACHINE" != "$MACHINE" ]; then
+    COMPARE_TIME=0
+    echo -e "${YELLOW}[WARN]${NC} Baseline recorded on '$BASE_MACHINE'; wall time not compared"
+fi
+if [ "$BASE_COMPILER" != "$COMPILER" ]; then
+    echo -e "${YELLOW}[WARN]${NC} Baseline built with '$BASE_COMPILER', now '$COMPILER'; instruction counts may shift"
+fi
+
+echo "============================================="
+echo "  Performance gate: $ARCH $MODE vs $BASELINE"
+echo "============================================="
+printf "  %-18s %-7s %12s %12s %8s  %s\n" "case" "metric" "baseline" "current" "change" "status"
+
+set +e
+awk -v itol="$ICOUNT_TOLERANCE" -v ttol="$TIME_TOLERANCE" -v tmin="$TIME_MIN_NS" \
+    -v time="$COMPARE_TIME" -v filter="$FILTER" -v strict="$([ "$PERF_TIME" = 1 ] && echo 1 || echo 0)" -v red="$RED" -v green="$GREEN" -v yellow="$YELLOW" -v nc="$NC" '
+    function value(key,    s) {
+        if (!match($0, "\"" key "\": [0-9.]+")) return "-"
+        s = substr($0, RSTART, RLENGTH); sub(/.*: /, "", s); return s
+    }
+    # One table row; returns 1 for a regression that fails the gate
+    function check(name, metric, base, cur, tol, floor, fatal,    change, status, color) {
+        if (base == "-" && cur == "-") return 0
+        if (base == "-") { status = "new"; color = yellow; change = "-" }
+        else if (cur == "-") { return 0 }
+        else {
+            change = base + 0 > 0 ? sprintf("%+.1f%%", (cur - base) * 100 / base) : "-"
+            if (cur > base * (1 + tol / 100) && cur - base > floor) {
+                status = fatal ? "REGRESSION" : "slower"; color = fatal ? red : yellow
+            }
+            else if (cur < base * (1 - tol / 100) && base - cur > floor) { status = "improved"; color = green }
+            else { status = "ok"; color = "" }
+        }
+        printf "  %-18s %-7s %12s %12s %8s  %s%s%s\n", name, metric, base, cur, change,
+               color, status, color == "" ? "" : nc
+        return status == "REGRESSION"
+    }
+    FNR == NR {
+        if (match($0, /"name": "[^"]*"/)) {
+            name = substr($0, RSTART + 9, RLENGTH - 10)
+            base[name] = 1; bi[name] = value("instructions_per_op"); bt[name] = value("ns_per_op")
+        }
+        next
+    }
+    {
+        seen[$1] = 1
+        failed += check($1, "insn", $1 in base ? bi[$1] : "-", $2, itol, 0, 1)
+        if (time) failed += check($1, "ns", $1 in base ? bt[$1] : "-", $3, ttol, tmin, strict)
+    }
+    END {
+        for (name in base) {
+            if (!(name in seen) && (filter == "" || name == filter || index(name, filter "/") == 1)) {
+                printf "  %-18s %-7s %12s %12s %8s  %s%s%s\n", name, "-", "-", "-", "-", red, "MISSING", nc
+                failed++
+            }
+        }
+        exit failed > 0
+    }' "$BASELINE" "$WORK/current"
+status=$?
+set -e
+
+echo "============================================="
+if [ $status -ne 0 ]; then
+    echo -e "  ${RED}Performance regression${NC} (tolerance: insn ${ICOUNT_TOLERANCE}%, time ${TIME_TOLERANCE}%)"
+    echo "  Intended? Re-record with: $0 -u $BINARY"
+    echo "============================================="
+    exit 1
+fi
+echo -e "  ${GREEN}Within tolerance${NC} (insn ${ICOUNT_TOLERANCE}%, time ${TIME_TOLERANCE}%)"
+echo "============================================="
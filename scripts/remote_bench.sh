@@ -0,0 +1,162 @@
+#!/bin/bash
+# ============================================================================
+# Remote Benchmarks - Run the Benchmark Suite on a Board and Gate the Results
+# ============================================================================
+# Usage: scripts/remote_bench.sh [-u] <IP> <BINARY> <DEST_DIR> <USER> <PASS>
+#   -u  record the board's results as the new baseline instead of comparing
+#
+# Deploys <BINARY> with ./deploy.sh (no gdbserver; the shared ssh connection
+# it opens carries the later sessions too), then runs --bench on the target
+# pinned to one CPU (taskset) with that CPU's cpufreq governor switched for
+# the run and restored afterwards. The harness JSON is pulled back to
+# $OUTPUT; its context carries the target's uname data, board and runtime
+# profile, and a "run" entry (--bench-context) records the target, machine,
+# CPU and governor used.
+#
+# The results then go through scripts/perf_gate.sh as the wall-time
+# measurement, with the target's "<uname -m> <cpu model name>" as the
+# machine, so baselines recorded on a board are compared only against the
+# same kind of board. Instruction counts are added when this machine can
+# count them for <BINARY> (valgrind for a native binary, RUNNER with
+# QEMU_INSN_PLUGIN for a cross binary), exactly as for make perf-gate.
+#
+# IP, USER and PASS are as for ./deploy.sh; IP "local" runs on this machine
+# (DEST_DIR is a local directory, USER and PASS are ignored).
+#
+# Environment:
+#   BENCH_CPU        CPU to pin to (default: the target's last online CPU)
+#   BENCH_GOVERNOR   cpufreq governor for the run (default: performance;
+#                    empty leaves it alone; needs root on the target)
+#   BENCH_RUN_ARGS   extra harness options (e.g. --bench-reps=20)
+#   OUTPUT           results file (default: build/bench/remote/<IP>-<BINARY>.json)
+#   ARCH, MODE, BASELINE_DIR, *_TOLERANCE, PERF_TIME, COMPILER, RUNNER,
+#   QEMU_INSN_PLUGIN as for scripts/perf_gate.sh
+#
+# Exits 1 when the deploy or the run fails or the gate finds a regression.
+# ============================================================================
+
+set -e
+
+CALLER_DIR="$PWD"
+cd "$(dirname "$0")/.." || exit 1
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+BENCH_GOVERNOR="${BENCH_GOVERNOR-performance}"
+
+UPDATE=()
+while getopts "uh" opt; do
+    case $opt in
+        u) UPDATE=(-u) ;;
+        *) sed -n '2,35p' "$0"; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 5 ]; then
+    echo "Usage: $0 [-u] <IP> <BINARY> <DEST_DIR> <USER> <PASS>" >&2
+    exit 2
+fi
+DEST_IP="$1"
+BINARY="$2"
+DEST_DIR="$3"
+USER="$4"
+PASS="$5"
+[[ $BINARY = /* ]] || BINARY="$CALLER_DIR/$BINARY"
+if [ ! -f "$BINARY" ]; then
+    echo -e "${RED}[FAIL]${NC} Binary $BINARY not found" >&2
+    exit 1
+fi
+NAME=$(basename "$BINARY")
+OUTPUT="${OUTPUT:-build/bench/remote/${DEST_IP//[:\/]/_}-$NAME.json}"
+
+# Same connection settings as deploy.sh, so its ControlMaster is reused
+SSH_OPTS=(-o StrictHostKeyChecking=no -o ConnectTimeout=10
+          -o ControlMaster=auto -o "ControlPath=${XDG_RUNTIME_DIR:-/tmp}/deploy-ssh-%C"
+          -o "ControlPersist=${DEPLOY_CONTROL_PERSIST:-600}")
+SSH_HOST="${DEST_IP%:*}"
+if [ "$SSH_HOST" != "$DEST_IP" ]; then
+    SSH_OPTS+=(-o "Port=${DEST_IP##*:}")
+fi
+
+# Run a shell command on the target
+remote() {
+    if [ "$DEST_IP" = local ]; then
+        sh -c "$1"
+    else
+        sshpass -p "$PASS" ssh "${SSH_OPTS[@]}" "$USER@$SSH_HOST" "$1"
+    fi
+}
+
+echo "==> Deploying $NAME to $DEST_IP:$DEST_DIR..."
+DEPLOY_GDBSERVER=0 ./deploy.sh "$DEST_IP" 0 "$BINARY" "$DEST_DIR" "$USER" "$PASS"
+
+# Pin, switch the governor (restored on exit), run; "remote-bench:" lines
+# describe the setup, everything else is harness output
+echo "==> Benchmarking on $DEST_IP..."
+LOG=$(mktemp)
+trap 'rm -f "$LOG"' EXIT
+RESULTS="$DEST_DIR/$NAME.bench.json"
+set +e
+remote "cd '$DEST_DIR' || exit 1
+    cpu=${BENCH_CPU:-\$((\$(getconf _NPROCESSORS_ONLN) - 1))}
+    gov=/sys/devices/system/cpu/cpu\$cpu/cpufreq/scaling_governor
+    old=\$(cat \$gov 2>/dev/null)
+    governor=\${old:-none}
+    if [ -n '$BENCH_GOVERNOR' ] && [ -n \"\$old\" ]; then
+        if { echo '$BENCH_GOVERNOR' > \$gov; } 2>/dev/null; then
+            trap 'echo \$old > \$gov' EXIT
+            governor='$BENCH_GOVERNOR'
+        else
+            echo \"remote-bench: warn cannot set governor $BENCH_GOVERNOR on cpu\$cpu (not root?), staying \$old\"
+        fi
+    fi
+    pin=''
+    if command -v taskset > /dev/null 2>&1; then
+        pin=\"taskset -c \$cpu\"
+    else
+        echo 'remote-bench: warn no taskset, running unpinned'
+        cpu=any
+    fi
+    machine=\"\$(uname -m) \$(awk -F': ' '/^model name/ { print \$2; exit }' /proc/cpuinfo)\"
+    echo \"remote-bench: machine \$machine\"
+    echo \"remote-bench: cpu \$cpu\"
+    echo \"remote-bench: governor \$governor\"
+    \$pin './$NAME' --bench --bench-json='$RESULTS' --bench-context='target=$DEST_IP' \\
+        \"--bench-context=machine=\$machine\" \"--bench-context=cpu=\$cpu\" \\
+        \"--bench-context=governor=\$governor\" $BENCH_RUN_ARGS 2>&1" | tee "$LOG" | grep -v '^remote-bench: '
+status=${PIPESTATUS[0]}
+set -e
+sed -n 's/^remote-bench: warn //p' "$LOG" | while read -r warning; do
+    echo -e "${YELLOW}[WARN]${NC} $warning"
+done
+if [ "$status" -ne 0 ]; then
+    echo -e "${RED}[FAIL]${NC} Benchmark run on $DEST_IP failed (exit $status)"
+    exit 1
+fi
+MACHINE=$(sed -n 's/^remote-bench: machine //p' "$LOG")
+MACHINE="${MACHINE% }"
+CPU=$(sed -n 's/^remote-bench: cpu //p' "$LOG")
+GOVERNOR=$(sed -n 's/^remote-bench: governor //p' "$LOG")
+
+# Pull the results back
+mkdir -p "$(dirname "$OUTPUT")"
+remote "cat '$RESULTS' && rm -f '$RESULTS'" > "$OUTPUT"
+if ! grep -q '"name"' "$OUTPUT"; then
+    echo -e "${RED}[FAIL]${NC} No benchmark results came back from $DEST_IP"
+    exit 1
+fi
+echo -e "${GREEN}[OK]${NC} Results: $OUTPUT (cpu $CPU, governor $GOVERNOR, $MACHINE)"
+
+# Instruction counts need valgrind and a native binary, or qemu for it;
+# otherwise the board's wall time is compared on its own
+PERF_ICOUNT=0
+if { [ -n "$RUNNER" ] && [ -f "$QEMU_INSN_PLUGIN" ]; } ||
+   { [ -z "$RUNNER" ] && [ "${MACHINE%% *}" = "$(uname -m)" ] && command -v valgrind &> /dev/null; }; then
+    PERF_ICOUNT=1
+fi
+BENCH_JSON="$OUTPUT" MACHINE="$MACHINE" PERF_ICOUNT=$PERF_ICOUNT scripts/perf_gate.sh "${UPDATE[@]}" "$BINARY"
@@ -0,0 +1,65 @@
+#!/bin/bash
+# ============================================================================
+# Size Report - Where the Bytes of a Binary Go
+# ============================================================================
+# Usage: scripts/size_report.sh <binary>
+#
+# Prints the allocated sections of <binary>, its largest symbols and the code
+# and data contributed by each object file next to it (one per source file,
+# so subsystems like the pipeline or memory pools can be tracked in bytes).
+# Symbols are read from <binary>.sym when present (minsize keeps the
+# unstripped copy there); stripped release binaries only get the sections.
+#
+# Environment:
+#   TOOL_PREFIX  binutils prefix for the binary's architecture
+#                (e.g. arm-linux-gnueabihf-; empty for the host)
+#   TOP          number of symbols to list (default: 15)
+# ============================================================================
+
+set -e
+
+TOP="${TOP:-15}"
+SIZE="${TOOL_PREFIX}size"
+NM="${TOOL_PREFIX}nm"
+
+if [ $# -ne 1 ] || [ ! -f "$1" ]; then
+    echo "Usage: $0 <binary>" >&2
+    exit 2
+fi
+
+BINARY="$1"
+SYMBOLS="$BINARY"
+[ -f "$BINARY.sym" ] && SYMBOLS="$BINARY.sym"
+
+echo "============================================="
+echo "  $BINARY ($(stat -c %s "$BINARY") bytes)"
+echo "============================================="
+
+echo "Sections (allocated, largest first):"
+"$SIZE" -A -d "$BINARY" | awk '$1 ~ /^\./ && $3 > 0 && $2 > 0 { printf "  %-22s %10d\n", $1, $2 }' \
+    | sort -k2,2nr
+"$SIZE" -B -d "$BINARY" | awk 'NR == 2 { printf "  %-22s %10d  (text %d, data %d, bss %d)\n", "total", $4, $1, $2, $3 }'
+echo ""
+
+echo "Top $TOP symbols:"
+if [ -n "$("$NM" "$SYMBOLS" 2>/dev/null | head -1)" ]; then
+    "$NM" --size-sort -r -S -C -t d "$SYMBOLS" | awk -v top="$TOP" '
+        $3 ~ /^[tTdDbBrRvVwW]$/ && n < top {
+            name = $4
+            for (i = 5; i <= NF; i++) name = name " " $i
+            if (length(name) > 96) name = substr(name, 1, 93) "..."
+            printf "  %8d %s %s\n", $2, $3, name
+            n++
+        }'
+else
+    echo "  (no symbol table: stripped binary)"
+fi
+echo ""
+
+OBJECTS=$(find "$(dirname "$BINARY")" -maxdepth 1 -name '*.o' | sort)
+if [ -n "$OBJECTS" ]; then
+    echo "Per object (before section GC / LTO):"
+    # shellcheck disable=SC2086
+    "$SIZE" -B -d $OBJECTS | awk 'NR > 1 { n = split($6, p, "/"); printf "  %-22s text %8d  data %6d  bss %6d\n", p[n], $1, $2, $3 }'
+fi
+echo ""
@@ -0,0 +1,167 @@
+#!/bin/bash
+# ============================================================================
+# Size Tracking - Per-Section and Per-Symbol Size Diff Against a Baseline
+# ============================================================================
+# Usage: scripts/size_track.sh [-u] <label> <binary>
+#   -u       record <binary> as the new baseline instead of comparing
+#   <label>  baseline name, normally <arch>-<variant> (e.g. arm64-release)
+#
+# Baselines are $BASELINE_DIR/<label>.tsv, sorted tab-separated lines that
+# diff well in review:
+#
+#   file     -                  <bytes>
+#   section  .text              <bytes>
+#   symbol   Logger::log(...)   <bytes>
+#
+# Symbols are read from <binary>.sym when present (release and minsize keep
+# the unstripped copy there) and summed per demangled name, so a function
+# inlined into more callers shows up as growth of those callers.
+#
+# Environment:
+#   TOOL_PREFIX     binutils prefix for the binary's architecture
+#                   (e.g. aarch64-linux-gnu-; empty for the host)
+#   BASELINE_DIR    baseline directory (default: <repo>/baselines/size)
+#   TOP             symbol changes listed, largest first (default: 20)
+#   SIZE_TOLERANCE  fail when the allocated size grows by more than this many
+#                   percent (default: empty, report only)
+#
+# Exits 1 when SIZE_TOLERANCE is exceeded, 0 otherwise (also when there is
+# no baseline yet).
+# ============================================================================
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+SIZE="${TOOL_PREFIX}size"
+NM="${TOOL_PREFIX}nm"
+BASELINE_DIR="${BASELINE_DIR:-$(dirname "$SCRIPT_DIR")/baselines/size}"
+TOP="${TOP:-20}"
+
+UPDATE=0
+while getopts "uh" opt; do
+    case $opt in
+        u) UPDATE=1 ;;
+        *) sed -n '2,30p' "$0"; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 2 ] || [ ! -f "$2" ]; then
+    echo "Usage: $0 [-u] <label> <binary>" >&2
+    exit 2
+fi
+LABEL="$1"
+BINARY="$2"
+BASELINE="$BASELINE_DIR/$LABEL.tsv"
+SYMBOLS="$BINARY"
+[ -f "$BINARY.sym" ] && SYMBOLS="$BINARY.sym"
+
+CURRENT=$(mktemp)
+trap 'rm -f "$CURRENT"' EXIT
+
+# Current sizes in baseline format
+{
+    printf "file\t-\t%d\n" "$(stat -c %s "$BINARY")"
+    "$SIZE" -A -d "$BINARY" | awk '$1 ~ /^\./ && $3 > 0 && $2 > 0 { printf "section\t%s\t%d\n", $1, $2 }'
+    if [ -n "$("$NM" "$SYMBOLS" 2>/dev/null | head -1)" ]; then
+        "$NM" -S -C -t d "$SYMBOLS" | awk '
+            NF >= 4 && $3 ~ /^[tTdDbBrRvVwW]$/ {
+                name = $4
+                for (i = 5; i <= NF; i++) name = name " " $i
+                size[name] += $2
+            }
+            END { for (name in size) printf "symbol\t%s\t%d\n", name, size[name] }'
+    else
+        echo -e "${YELLOW}[WARN]${NC} $BINARY has no symbol table; tracking sections only" >&2
+    fi
+} | LC_ALL=C sort -t "$(printf '\t')" -k1,1 -k2,2 > "$CURRENT"
+
+if [ $UPDATE -eq 1 ]; then
+    mkdir -p "$BASELINE_DIR"
+    cp "$CURRENT" "$BASELINE"
+    echo -e "${GREEN}[OK]${NC} Size baseline written: $BASELINE ($(grep -c '^symbol' "$BASELINE" || true) symbols)"
+    exit 0
+fi
+
+if [ ! -f "$BASELINE" ]; then
+    echo -e "${YELLOW}[WARN]${NC} No size baseline $BASELINE; record one with $0 -u $LABEL $BINARY"
+    exit 0
+fi
+
+echo "============================================="
+echo "  $LABEL: $BINARY vs $BASELINE"
+echo "============================================="
+
+set +e
+awk -F '\t' -v top="$TOP" -v tolerance="$SIZE_TOLERANCE" \
+    -v red="$RED" -v green="$GREEN" -v nc="$NC" '
+    function delta(a, b) { return a > 0 ? sprintf("%+.1f%%", (b - a) * 100 / a) : "-" }
+    function row(name, a, b,    color) {
+        color = b > a ? red : (b < a ? green : "")
+        printf "  %-22s %10d %10d %s%+9d%s %8s\n", name, a, b, color, b - a, color == "" ? "" : nc, delta(a, b)
+    }
+    {
+        key = $1 "\t" $2
+        if (!(key in seen)) { seen[key] = 1; keys[++count] = key }
+        if (FNR == NR) base[key] = $3; else cur[key] = $3
+    }
+    END {
+        printf "  %-22s %10s %10s %10s %8s\n", "section", "baseline", "current", "delta", "change"
+        for (i = 1; i <= count; i++) {
+            split(keys[i], k, "\t")
+            if (k[1] == "symbol") continue
+            a = base[keys[i]] + 0; b = cur[keys[i]] + 0
+            if (k[1] == "file") { fileA = a; fileB = b; continue }
+            if (a != b) row(k[2], a, b)
+            totalA += a; totalB += b
+        }
+        row("allocated", totalA, totalB)
+        row("file", fileA, fileB)
+
+        # Symbol changes, largest absolute delta first
+        n = 0
+        for (i = 1; i <= count; i++) {
+            split(keys[i], k, "\t")
+            if (k[1] != "symbol") continue
+            a = base[keys[i]] + 0; b = cur[keys[i]] + 0
+            if (a == b) continue
+            d = b - a
+            names[++n] = k[2]; deltas[n] = d
+            status[n] = !(keys[i] in base) ? "new" : (!(keys[i] in cur) ? "removed" : (d > 0 ? "grew" : "shrank"))
+            sizes[n] = b
+            if (d > 0) grew += d; else shrank -= d
+        }
+        for (i = 2; i <= n; i++) {
+            for (j = i; j > 1 && (deltas[j] < 0 ? -deltas[j] : deltas[j]) > (deltas[j - 1] < 0 ? -deltas[j - 1] : deltas[j - 1]); j--) {
+                t = names[j]; names[j] = names[j - 1]; names[j - 1] = t
+                t = deltas[j]; deltas[j] = deltas[j - 1]; deltas[j - 1] = t
+                t = status[j]; status[j] = status[j - 1]; status[j - 1] = t
+                t = sizes[j]; sizes[j] = sizes[j - 1]; sizes[j - 1] = t
+            }
+        }
+        print ""
+        printf "  Symbols: %d changed, +%d / -%d bytes\n", n, grew, shrank
+        for (i = 1; i <= n && i <= top; i++) {
+            color = deltas[i] > 0 ? red : green
+            name = names[i]
+            if (length(name) > 80) name = substr(name, 1, 77) "..."
+            printf "  %s%+8d%s %8d  %-7s %s\n", color, deltas[i], nc, sizes[i], status[i], name
+        }
+        if (n > top) printf "  ... %d more (TOP=%d)\n", n - top, top
+
+        if (tolerance != "" && totalB > totalA * (1 + tolerance / 100)) {
+            printf "\n  %sAllocated size grew %s, over the %s%% tolerance%s\n", red, delta(totalA, totalB), tolerance, nc
+            exit 1
+        }
+    }' "$BASELINE" "$CURRENT"
+status=$?
+set -e
+echo "============================================="
+exit $status
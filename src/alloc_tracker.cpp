@@ -0,0 +1,253 @@
+/**
+ * @file alloc_tracker.cpp
+ * @brief Per-phase allocation tracking fed by the malloc interposer
+ *
+ * Only compiled in when ALLOC_TRACKING is defined (make ... ALLOC_TRACK=1).
+ * Events arrive from src/malloc_hooks.cpp. Nothing here may allocate on the
+ * reporting path: messages are formatted into stack buffers and written with
+ * write(2).
+ */
+
+#ifdef ALLOC_TRACKING
+
+#include "alloc_tracker.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "logger.h"
+#include "malloc_hooks.h"
+
+namespace {
+
+struct PhaseCounters {
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> frees;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> peakLive;
+};
+
+// Init-phase allocation site, keyed by the first return address in the executable
+struct CallSite {
+    std::atomic<void *> address;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> bytes;
+};
+
+// Zero-initialized before any constructor runs, so early allocations are safe
+PhaseCounters g_phases[static_cast<int>(AllocPhase::PHASE_COUNT)];
+CallSite g_sites[ALLOC_TRACK_MAX_SITES];
+std::atomic<uint64_t> g_droppedSites;
+std::atomic<int> g_phase;
+std::atomic<int64_t> g_liveBytes;
+std::atomic<uint64_t> g_violations;
+std::atomic<bool> g_abortOnViolation;
+const void *g_exeBase;
+
+// Set while a thread is inside the tracker (backtrace() may allocate)
+thread_local bool t_inTracker = false;
+
+void writeStderr(const char *text) {
+    ssize_t ignored = write(STDERR_FILENO, text, strlen(text));
+    (void)ignored;
+}
+
+// Return address of the first frame inside the main executable at or above @p caller
+void *findCallSite(void *caller) {
+    if (g_exeBase == nullptr) {
+        return caller;
+    }
+    void *frames[12];
+    int depth = backtrace(frames, static_cast<int>(ARRAY_SIZE(frames)));
+    int start = 0;
+    while (start < depth && frames[start] != caller) {
+        start++;
+    }
+    for (int i = (start < depth ? start : 0); i < depth; i++) {
+        Dl_info info;
+        if (dladdr(frames[i], &info) != 0 && info.dli_fbase == g_exeBase) {
+            return frames[i];
+        }
+    }
+    return caller;
+}
+
+void recordSite(void *caller, size_t size) {
+    void *site = findCallSite(caller);
+    size_t slot = (reinterpret_cast<uintptr_t>(site) >> 2) % ALLOC_TRACK_MAX_SITES;
+    for (size_t probe = 0; probe < ALLOC_TRACK_MAX_SITES; probe++) {
+        CallSite &entry = g_sites[(slot + probe) % ALLOC_TRACK_MAX_SITES];
+        void *expected = nullptr;
+        if (entry.address.load(std::memory_order_acquire) == site ||
+            entry.address.compare_exchange_strong(expected, site, std::memory_order_acq_rel) ||
+            expected == site) {
+            entry.count.fetch_add(1, std::memory_order_relaxed);
+            entry.bytes.fetch_add(size, std::memory_order_relaxed);
+            return;
+        }
+    }
+    g_droppedSites.fetch_add(1, std::memory_order_relaxed);
+}
+
+void reportViolation(void *caller, size_t size) {
+    uint64_t count = g_violations.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (count <= ALLOC_TRACK_MAX_REPORTS) {
+        char site[256];
+        char line[384];
+        mallocHooksFormatAddress(findCallSite(caller), site, sizeof(site));
+        snprintf(line, sizeof(line), "[ALLOC] steady-state allocation #%llu: %zu bytes at %s\n",
+                 static_cast<unsigned long long>(count), size, site);
+        writeStderr(line);
+#ifdef DEBUG
+        void *frames[24];
+        int depth = backtrace(frames, static_cast<int>(ARRAY_SIZE(frames)));
+        backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+#endif
+        if (count == ALLOC_TRACK_MAX_REPORTS) {
+            writeStderr("[ALLOC] further steady-state allocations are only counted\n");
+        }
+    }
+    if (g_abortOnViolation.load(std::memory_order_relaxed)) {
+        writeStderr("[ALLOC] aborting: heap allocation after mainLoop start\n");
+        abort();
+    }
+}
+
+void logInitSummary() {
+    AllocPhaseStats init = AllocTracker::stats(AllocPhase::PHASE_INIT);
+    LOG_INFO("Init allocations: %llu calls, %llu bytes requested, peak live %llu bytes",
+             static_cast<unsigned long long>(init.allocations),
+             static_cast<unsigned long long>(init.bytes),
+             static_cast<unsigned long long>(init.peakLive));
+
+    // Selection sort of the (small) site table by bytes, largest first
+    size_t order[ALLOC_TRACK_MAX_SITES];
+    size_t used = 0;
+    for (size_t i = 0; i < ALLOC_TRACK_MAX_SITES; i++) {
+        if (g_sites[i].address.load(std::memory_order_relaxed) != nullptr) {
+            order[used++] = i;
+        }
+    }
+    for (size_t i = 0; i < used; i++) {
+        for (size_t j = i + 1; j < used; j++) {
+            if (g_sites[order[j]].bytes.load() > g_sites[order[i]].bytes.load()) {
+                size_t tmp = order[i];
+                order[i] = order[j];
+                order[j] = tmp;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < used; i++) {
+        const CallSite &entry = g_sites[order[i]];
+        char site[256];
+        mallocHooksFormatAddress(entry.address.load(), site, sizeof(site));
+        LOG_INFO("  %8llu bytes %5llu calls  %s", static_cast<unsigned long long>(entry.bytes.load()),
+                 static_cast<unsigned long long>(entry.count.load()), site);
+    }
+    if (g_droppedSites.load() > 0) {
+        LOG_INFO("  (%llu allocations from sites beyond the %d-entry table)",
+                 static_cast<unsigned long long>(g_droppedSites.load()), ALLOC_TRACK_MAX_SITES);
+    }
+}
+
+/**
+ * Runs before other static constructors: locates the main executable so call
+ * sites can skip library frames (e.g. operator new inside libstdc++), and
+ * calls backtrace() once because it loads libgcc_s on first use.
+ */
+__attribute__((constructor(101))) void initTracker() {
+    t_inTracker = true;
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&initTracker), &info) != 0) {
+        g_exeBase = info.dli_fbase;
+    }
+    void *frames[4];
+    backtrace(frames, static_cast<int>(ARRAY_SIZE(frames)));
+    t_inTracker = false;
+}
+
+}  // namespace
+
+void allocTrackerOnAllocate(size_t size, size_t usable, void *caller) {
+    int phase = g_phase.load(std::memory_order_relaxed);
+    PhaseCounters &counters = g_phases[phase];
+    int64_t live = g_liveBytes.fetch_add(static_cast<int64_t>(usable), std::memory_order_relaxed) +
+                   static_cast<int64_t>(usable);
+    uint64_t peak = counters.peakLive.load(std::memory_order_relaxed);
+    while (live > 0 && static_cast<uint64_t>(live) > peak &&
+           !counters.peakLive.compare_exchange_weak(peak, static_cast<uint64_t>(live),
+                                                    std::memory_order_relaxed)) {
+    }
+
+    if (t_inTracker) {
+        return;
+    }
+    t_inTracker = true;
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    if (phase == static_cast<int>(AllocPhase::PHASE_INIT)) {
+        recordSite(caller, size);
+    } else if (phase == static_cast<int>(AllocPhase::PHASE_STEADY)) {
+        reportViolation(caller, size);
+    }
+    t_inTracker = false;
+}
+
+void allocTrackerOnFree(size_t usable) {
+    g_liveBytes.fetch_sub(static_cast<int64_t>(usable), std::memory_order_relaxed);
+    if (!t_inTracker) {
+        g_phases[g_phase.load(std::memory_order_relaxed)].frees.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AllocTracker::setPhase(AllocPhase phase) {
+    if (phase == AllocPhase::PHASE_STEADY) {
+        const char *policy = getenv(ALLOC_TRACK_POLICY_ENV);
+        g_abortOnViolation = (policy != nullptr && strcmp(policy, "abort") == 0);
+        logInitSummary();
+        LOG_INFO("Allocation tracking: steady state begins (policy: %s)",
+                 g_abortOnViolation ? "abort" : "warn");
+    }
+    g_phase.store(static_cast<int>(phase), std::memory_order_release);
+}
+
+AllocPhase AllocTracker::phase() {
+    return static_cast<AllocPhase>(g_phase.load(std::memory_order_acquire));
+}
+
+AllocPhaseStats AllocTracker::stats(AllocPhase phase) {
+    const PhaseCounters &counters = g_phases[static_cast<int>(phase)];
+    AllocPhaseStats s;
+    s.allocations = counters.allocations.load(std::memory_order_relaxed);
+    s.frees = counters.frees.load(std::memory_order_relaxed);
+    s.bytes = counters.bytes.load(std::memory_order_relaxed);
+    s.peakLive = counters.peakLive.load(std::memory_order_relaxed);
+    return s;
+}
+
+void AllocTracker::report() {
+    static const char *names[] = {"init", "steady", "shutdown"};
+    LOG_INFO("Allocation tracking summary:");
+    for (int i = 0; i < static_cast<int>(AllocPhase::PHASE_COUNT); i++) {
+        AllocPhaseStats s = stats(static_cast<AllocPhase>(i));
+        LOG_INFO("  %-8s alloc %llu  free %llu  bytes %llu  peak live %llu", names[i],
+                 static_cast<unsigned long long>(s.allocations),
+                 static_cast<unsigned long long>(s.frees), static_cast<unsigned long long>(s.bytes),
+                 static_cast<unsigned long long>(s.peakLive));
+    }
+    uint64_t violations = g_violations.load();
+    if (violations > 0) {
+        LOG_ERROR("%llu heap allocations after mainLoop start", static_cast<unsigned long long>(violations));
+    } else {
+        LOG_INFO("No heap allocations after mainLoop start");
+    }
+}
+
+#endif  // ALLOC_TRACKING
@@ -0,0 +1,54 @@
+/**
+ * @file bench_suites.cpp
+ * @brief Benchmark suites for the logger and main loop scheduling
+ *
+ * Run with --bench (see include/benchmark.h). The pipeline and loop tick
+ * benchmarks live in main.cpp next to the state they exercise.
+ */
+
+#include <unistd.h>
+
+#include "benchmark.h"
+#include "logger.h"
+
+// Full log call: level check, timestamp, header and message formatting, write
+static void benchLoggerEnabled(BenchState &state) {
+    Logger::getInstance().setLevel(LogLevel::LVL_INFO);
+    long i = 0;
+    while (state.next()) {
+        LOG_INFO("Benchmark message %ld value=%.2f", i, i * 0.5);
+        i++;
+    }
+}
+BENCHMARK("logger/enabled", benchLoggerEnabled, 100000);
+
+// Call below the minimum level: only the level check runs
+static void benchLoggerFiltered(BenchState &state) {
+    Logger::getInstance().setLevel(LogLevel::LVL_INFO);
+    long i = 0;
+    while (state.next()) {
+        LOG_DEBUG("Filtered message %ld value=%.2f", i, i * 0.5);
+        clobberMemory();
+        i++;
+    }
+}
+BENCHMARK("logger/filtered", benchLoggerFiltered, 10000000);
+
+// Timestamp formatting done for every emitted log line
+static void benchTimestamp(BenchState &state) {
+    char buffer[32];
+    while (state.next()) {
+        Logger::getTimestamp(buffer, sizeof(buffer));
+        doNotOptimize(buffer);
+    }
+}
+BENCHMARK("logger/timestamp", benchTimestamp, 100000);
+
+// Time actually spent in a 1 ms usleep(); the excess over 1000000 ns/op is
+// the wake-up latency added to every mainLoop period
+static void benchLoopSleep(BenchState &state) {
+    while (state.next()) {
+        usleep(1000);
+    }
+}
+BENCHMARK("loop/sleep_1ms", benchLoopSleep, 200);
@@ -0,0 +1,231 @@
+/**
+ * @file benchmark.cpp
+ * @brief Benchmark registry, batch runner, statistics and JSON output
+ */
+
+#include "benchmark.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/utsname.h>
+
+#include "config.h"
+#include "logger.h"
+
+namespace {
+
+struct BenchCase {
+    const char *name;
+    BenchFunction function;
+    long iterations;
+};
+
+// Filled during static initialization, before main() runs
+BenchCase g_cases[BENCH_MAX_CASES];
+int g_caseCount = 0;
+
+struct BenchSummary {
+    double minNs;
+    double medianNs;
+    double meanNs;
+    double maxNs;
+    double stddevNs;
+};
+
+bool matches(const char *name, const char *filter) {
+    if (filter == nullptr) {
+        return true;
+    }
+    size_t length = strlen(filter);
+    return strncmp(name, filter, length) == 0 && (name[length] == '\0' || name[length] == '/');
+}
+
+// Write @p text as a quoted JSON string (null as ""), escaping quotes,
+// backslashes and control characters
+void writeJsonString(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const char *c = text ? text : ""; *c != '\0'; c++) {
+        unsigned char ch = static_cast<unsigned char>(*c);
+        if (ch == '"' || ch == '\\') {
+            fputc('\\', out);
+            fputc(ch, out);
+        } else if (ch < 0x20) {
+            fprintf(out, "\\u%04x", ch);
+        } else {
+            fputc(ch, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// Write "key": "value" with both parts escaped
+void writeJsonField(FILE *out, const char *separator, const char *key, const char *value) {
+    fputs(separator, out);
+    writeJsonString(out, key);
+    fputs(": ", out);
+    writeJsonString(out, value);
+}
+
+BenchSummary summarize(double *samples, int count) {
+    // Insertion sort: count is at most BENCH_MAX_REPETITIONS
+    for (int i = 1; i < count; i++) {
+        double value = samples[i];
+        int j = i - 1;
+        while (j >= 0 && samples[j] > value) {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+        samples[j + 1] = value;
+    }
+
+    BenchSummary summary;
+    summary.minNs = samples[0];
+    summary.maxNs = samples[count - 1];
+    summary.medianNs = count % 2 ? samples[count / 2]
+                                 : (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    summary.meanNs = sum / count;
+    double variance = 0.0;
+    for (int i = 0; i < count; i++) {
+        variance += (samples[i] - summary.meanNs) * (samples[i] - summary.meanNs);
+    }
+    summary.stddevNs = count > 1 ? sqrt(variance / (count - 1)) : 0.0;
+    return summary;
+}
+
+}  // namespace
+
+void Benchmarks::add(const char *name, BenchFunction function, long iterations) {
+    if (g_caseCount >= BENCH_MAX_CASES) {
+        fprintf(stderr, "Benchmark table full, dropping %s\n", name);
+        return;
+    }
+    // Keep the table sorted by name so output order does not depend on link order
+    int i = g_caseCount++;
+    while (i > 0 && strcmp(g_cases[i - 1].name, name) > 0) {
+        g_cases[i] = g_cases[i - 1];
+        i--;
+    }
+    g_cases[i] = BenchCase{name, function, iterations > 0 ? iterations : BENCH_DEFAULT_ITERATIONS};
+}
+
+int Benchmarks::run(const BenchOptions &options) {
+    int repetitions = options.repetitions;
+    if (repetitions < 1) {
+        repetitions = 1;
+    } else if (repetitions > BENCH_MAX_REPETITIONS) {
+        repetitions = BENCH_MAX_REPETITIONS;
+    }
+
+    FILE *sink = fopen("/dev/null", "w");
+    if (sink == nullptr) {
+        LOG_ERROR("Cannot open /dev/null for benchmark log output");
+        return -1;
+    }
+    FILE *json = nullptr;
+    if (options.jsonPath != nullptr) {
+        json = fopen(options.jsonPath, "w");
+        if (json == nullptr) {
+            LOG_ERROR("Cannot write benchmark results to %s: %s", options.jsonPath, strerror(errno));
+            fclose(sink);
+            return -1;
+        }
+        // Where the numbers came from, as printSystemInfo() reports it
+        struct utsname sysinfo;
+        if (uname(&sysinfo) != 0) {
+            memset(&sysinfo, 0, sizeof(sysinfo));
+        }
+        writeJsonField(json, "{\"context\": {", "project", PROJECT_NAME);
+        writeJsonField(json, ", ", "version", PROJECT_VERSION_STRING);
+        writeJsonField(json, ", ", "arch", options.arch);
+        writeJsonField(json, ", ", "mode", options.mode);
+        if (options.filter != nullptr) {
+            // A partial run: consumers must not expect the other cases
+            writeJsonField(json, ", ", "filter", options.filter);
+        }
+        fprintf(json, ", \"repetitions\": %d, \"warmup\": %d,\n", repetitions, options.warmup);
+        writeJsonField(json, "  \"system\": {", "sysname", sysinfo.sysname);
+        writeJsonField(json, ", ", "node", sysinfo.nodename);
+        writeJsonField(json, ", ", "release", sysinfo.release);
+        writeJsonField(json, ", ", "machine", sysinfo.machine);
+        writeJsonField(json, ", ", "board", options.board);
+        writeJsonField(json, ", ", "runtime", options.runtime);
+        fputc('}', json);
+        // How the run was set up (target, CPU, governor...), from the caller
+        if (options.contextCount > 0) {
+            fputs(",\n  \"run\": {", json);
+            for (int i = 0; i < options.contextCount; i++) {
+                const char *entry = options.context[i];
+                const char *equals = strchr(entry, '=');
+                char key[64];
+                snprintf(key, sizeof(key), "%.*s",
+                         static_cast<int>(equals ? equals - entry : strlen(entry)), entry);
+                writeJsonField(json, i ? ", " : "", key, equals ? equals + 1 : "");
+            }
+            fputc('}', json);
+        }
+        fprintf(json, "},\n \"benchmarks\": [");
+    }
+
+    LOG_INFO("Running benchmarks (%d repetitions, %d warmup)...", repetitions, options.warmup);
+
+    // Benchmarks that log must not flood the terminal or pay for it
+    Logger &logger = Logger::getInstance();
+    FILE *output = logger.getOutput();
+    LogLevel level = logger.getLevel();
+    logger.setOutput(sink);
+
+    int ran = 0;
+    for (int c = 0; c < g_caseCount; c++) {
+        const BenchCase &bench = g_cases[c];
+        if (!matches(bench.name, options.filter)) {
+            continue;
+        }
+        long iterations = options.iterations > 0 ? options.iterations : bench.iterations;
+
+        for (int w = 0; w < options.warmup; w++) {
+            BenchState state(iterations);
+            bench.function(state);
+        }
+        double samples[BENCH_MAX_REPETITIONS];
+        for (int r = 0; r < repetitions; r++) {
+            BenchState state(iterations);
+            bench.function(state);
+            samples[r] = static_cast<double>(state.elapsedNs()) / iterations;
+        }
+        logger.setLevel(level);
+
+        BenchSummary summary = summarize(samples, repetitions);
+        double cv = summary.meanNs > 0.0 ? summary.stddevNs * 100.0 / summary.meanNs : 0.0;
+        printf("bench %s %.1f ns/op  min %.1f  max %.1f  cv %.1f%%  (%ld x %d)\n", bench.name,
+               summary.medianNs, summary.minNs, summary.maxNs, cv, iterations, repetitions);
+        if (json != nullptr) {
+            writeJsonField(json, ran ? ",\n  {" : "\n  {", "name", bench.name);
+            fprintf(json, ", \"iterations\": %ld, \"ns_per_op\": %.3f, \"min\": %.3f, "
+                          "\"mean\": %.3f, \"max\": %.3f, \"stddev\": %.3f}",
+                    iterations, summary.medianNs, summary.minNs, summary.meanNs, summary.maxNs,
+                    summary.stddevNs);
+        }
+        ran++;
+    }
+    fflush(stdout);
+
+    logger.setOutput(output);
+    logger.setLevel(level);
+    fclose(sink);
+    if (json != nullptr) {
+        fprintf(json, "\n]}\n");
+        fclose(json);
+        LOG_INFO("Benchmark results written to %s", options.jsonPath);
+    }
+    if (ran == 0) {
+        LOG_WARN("No benchmark matches '%s'", options.filter ? options.filter : "");
+    }
+    return ran;
+}
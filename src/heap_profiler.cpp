@@ -0,0 +1,545 @@
+/**
+ * @file heap_profiler.cpp
+ * @brief Poisson-sampled heap profiler fed by the malloc interposer
+ *
+ * Only compiled in when HEAP_PROFILING is defined (make ... HEAP_PROFILE=1).
+ * All state lives in fixed-size static tables guarded by a spinlock that is
+ * only taken for sampled allocations and for frees that pass a counting
+ * filter of sampled addresses, so the common path is a thread-local
+ * subtraction on malloc and one relaxed load on free.
+ */
+
+#ifdef HEAP_PROFILING
+
+#include "heap_profiler.h"
+
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "logger.h"
+#include "malloc_hooks.h"
+
+// Counting filter slots for sampled addresses (power of two)
+#define HEAP_PROFILE_FILTER_SLOTS 65536
+
+namespace {
+
+struct StackBucket {
+    uint64_t hash;  // 0 = unused
+    int depth;
+    void *frames[HEAP_PROFILE_MAX_DEPTH];
+    uint64_t allocCount;    // sampled allocations
+    uint64_t allocBytes;    // sampled bytes
+    uint64_t liveCount;     // sampled allocations not yet freed
+    uint64_t liveBytes;     // their bytes
+    double liveEstimate;    // live bytes scaled up by the sampling probability
+};
+
+struct LiveBlock {
+    void *ptr;  // nullptr = empty slot
+    size_t size;
+    double estimate;
+    int bucket;
+};
+
+StackBucket g_buckets[HEAP_PROFILE_MAX_STACKS];
+LiveBlock g_live[HEAP_PROFILE_MAX_LIVE];
+// Live sampled blocks per filter slot; wide enough for the whole live table
+std::atomic<uint16_t> g_filter[HEAP_PROFILE_FILTER_SLOTS];
+static_assert(HEAP_PROFILE_MAX_LIVE <= UINT16_MAX, "filter counters could wrap");
+std::atomic_flag g_lock = ATOMIC_FLAG_INIT;
+
+// Copy of the used buckets that dump() writes out without holding g_lock
+StackBucket g_snapshot[HEAP_PROFILE_MAX_STACKS];
+std::atomic_flag g_snapshotLock = ATOMIC_FLAG_INIT;
+
+std::atomic<uint64_t> g_rate(HEAP_PROFILE_DEFAULT_RATE);
+std::atomic<bool> g_dumpRequested(false);
+uint64_t g_droppedSamples;  // stack or live table full
+unsigned g_dumpSequence;
+char g_prefix[256] = HEAP_PROFILE_DEFAULT_PREFIX;
+
+thread_local bool t_inProfiler = false;
+thread_local bool t_samplerReady = false;
+thread_local int64_t t_bytesUntilSample = 0;
+thread_local uint64_t t_rng = 0;
+
+class SpinLock {
+public:
+    explicit SpinLock(std::atomic_flag &flag = g_lock) : flag_(flag) {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+            sched_yield();
+        }
+    }
+    ~SpinLock() {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag &flag_;
+};
+
+size_t hashPointer(const void *ptr) {
+    uint64_t value = reinterpret_cast<uintptr_t>(ptr);
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    return static_cast<size_t>(value);
+}
+
+// Exponentially distributed gap with the configured mean (xorshift64* RNG)
+int64_t nextSampleGap() {
+    if (t_rng == 0) {
+        t_rng = hashPointer(&t_rng) | 1;
+    }
+    t_rng ^= t_rng >> 12;
+    t_rng ^= t_rng << 25;
+    t_rng ^= t_rng >> 27;
+    uint64_t bits = (t_rng * 0x2545F4914F6CDD1DULL) >> 11;
+    double uniform = (static_cast<double>(bits) + 1.0) / 9007199254740993.0;  // (0, 1]
+    double gap = -log(uniform) * static_cast<double>(g_rate.load(std::memory_order_relaxed));
+    return static_cast<int64_t>(gap) + 1;
+}
+
+int findOrAddBucket(void *const *frames, int depth) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (int i = 0; i < depth; i++) {
+        hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ULL;
+    }
+    hash |= 1;
+
+    size_t start = hash % HEAP_PROFILE_MAX_STACKS;
+    for (size_t probe = 0; probe < HEAP_PROFILE_MAX_STACKS; probe++) {
+        size_t index = (start + probe) % HEAP_PROFILE_MAX_STACKS;
+        StackBucket &bucket = g_buckets[index];
+        if (bucket.hash == 0) {
+            bucket.hash = hash;
+            bucket.depth = depth;
+            memcpy(bucket.frames, frames, depth * sizeof(void *));
+            return static_cast<int>(index);
+        }
+        if (bucket.hash == hash && bucket.depth == depth &&
+            memcmp(bucket.frames, frames, depth * sizeof(void *)) == 0) {
+            return static_cast<int>(index);
+        }
+    }
+    return -1;
+}
+
+// Linear-probing live table; caller holds the lock
+size_t liveSlot(const void *ptr) {
+    return hashPointer(ptr) % HEAP_PROFILE_MAX_LIVE;
+}
+
+LiveBlock *findLive(const void *ptr) {
+    size_t index = liveSlot(ptr);
+    for (size_t probe = 0; probe < HEAP_PROFILE_MAX_LIVE; probe++) {
+        LiveBlock &block = g_live[(index + probe) % HEAP_PROFILE_MAX_LIVE];
+        if (block.ptr == nullptr) {
+            return nullptr;
+        }
+        if (block.ptr == ptr) {
+            return &block;
+        }
+    }
+    return nullptr;
+}
+
+// Remove with backward-shift deletion so no tombstones accumulate
+void removeLive(LiveBlock *victim) {
+    StackBucket &bucket = g_buckets[victim->bucket];
+    bucket.liveCount--;
+    bucket.liveBytes -= victim->size;
+    bucket.liveEstimate -= victim->estimate;
+    g_filter[hashPointer(victim->ptr) % HEAP_PROFILE_FILTER_SLOTS].fetch_sub(1, std::memory_order_relaxed);
+
+    size_t hole = static_cast<size_t>(victim - g_live);
+    size_t next = (hole + 1) % HEAP_PROFILE_MAX_LIVE;
+    while (g_live[next].ptr != nullptr) {
+        size_t home = liveSlot(g_live[next].ptr);
+        bool movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            g_live[hole] = g_live[next];
+            hole = next;
+        }
+        next = (next + 1) % HEAP_PROFILE_MAX_LIVE;
+    }
+    g_live[hole].ptr = nullptr;
+}
+
+bool insertLive(void *ptr, size_t size, double estimate, int bucket) {
+    LiveBlock *stale = findLive(ptr);
+    if (stale != nullptr) {
+        removeLive(stale);  // freed while the profiler was busy; address reused
+    }
+    size_t index = liveSlot(ptr);
+    for (size_t probe = 0; probe < HEAP_PROFILE_MAX_LIVE; probe++) {
+        LiveBlock &block = g_live[(index + probe) % HEAP_PROFILE_MAX_LIVE];
+        if (block.ptr == nullptr) {
+            block.ptr = ptr;
+            block.size = size;
+            block.estimate = estimate;
+            block.bucket = bucket;
+            g_filter[hashPointer(ptr) % HEAP_PROFILE_FILTER_SLOTS].fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void recordSample(void *ptr, size_t size, void *caller) {
+    void *frames[HEAP_PROFILE_MAX_DEPTH + 4];
+    int depth = backtrace(frames, static_cast<int>(ARRAY_SIZE(frames)));
+    int first = 0;
+    while (first < depth && frames[first] != caller) {
+        first++;
+    }
+    if (first == depth) {
+        first = 0;
+    }
+    depth -= first;
+    if (depth > HEAP_PROFILE_MAX_DEPTH) {
+        depth = HEAP_PROFILE_MAX_DEPTH;
+    }
+
+    // Each sample stands for size / P(sampled) bytes
+    double rate = static_cast<double>(g_rate.load(std::memory_order_relaxed));
+    double estimate = static_cast<double>(size) / (1.0 - exp(-static_cast<double>(size) / rate));
+
+    SpinLock lock;
+    int bucket = findOrAddBucket(frames + first, depth);
+    if (bucket < 0) {
+        g_droppedSamples++;
+        return;
+    }
+    StackBucket &stack = g_buckets[bucket];
+    stack.allocCount++;
+    stack.allocBytes += size;
+    if (insertLive(ptr, size, estimate, bucket)) {
+        stack.liveCount++;
+        stack.liveBytes += size;
+        stack.liveEstimate += estimate;
+    } else {
+        g_droppedSamples++;
+    }
+}
+
+// Buffered writer on top of write(2); never allocates
+class FileWriter {
+public:
+    explicit FileWriter(const char *path)
+        : fd_(open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)), used_(0) {}
+
+    ~FileWriter() {
+        flush();
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool ok() const {
+        return fd_ >= 0;
+    }
+
+    void printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char line[512];
+        va_list args;
+        va_start(args, fmt);
+        int len = vsnprintf(line, sizeof(line), fmt, args);
+        va_end(args);
+        if (len > 0) {
+            append(line, len < static_cast<int>(sizeof(line)) ? static_cast<size_t>(len) : sizeof(line) - 1);
+        }
+    }
+
+    void append(const char *data, size_t len) {
+        if (used_ + len > sizeof(buffer_)) {
+            flush();
+        }
+        if (len > sizeof(buffer_)) {
+            writeAll(data, len);
+            return;
+        }
+        memcpy(buffer_ + used_, data, len);
+        used_ += len;
+    }
+
+    void flush() {
+        writeAll(buffer_, used_);
+        used_ = 0;
+    }
+
+private:
+    void writeAll(const char *data, size_t len) {
+        while (fd_ >= 0 && len > 0) {
+            ssize_t written = write(fd_, data, len);
+            if (written <= 0) {
+                break;
+            }
+            data += written;
+            len -= static_cast<size_t>(written);
+        }
+    }
+
+    int fd_;
+    size_t used_;
+    char buffer_[4096];
+};
+
+// Symbol name for folded stacks: no spaces or ';' allowed
+void foldedFrameName(const void *address, char *buffer, size_t size) {
+    Dl_info info;
+    if (dladdr(address, &info) != 0 && info.dli_sname != nullptr) {
+        snprintf(buffer, size, "%s", info.dli_sname);
+    } else if (info.dli_fname != nullptr && info.dli_fbase != nullptr) {
+        const char *module = strrchr(info.dli_fname, '/');
+        snprintf(buffer, size, "%s+0x%lx", module ? module + 1 : info.dli_fname,
+                 static_cast<unsigned long>(reinterpret_cast<uintptr_t>(address) -
+                                            reinterpret_cast<uintptr_t>(info.dli_fbase)));
+    } else {
+        snprintf(buffer, size, "%p", address);
+    }
+}
+
+// gperftools heap_v2 text format; pprof un-samples using the rate in the header
+void writePprof(const char *path, const StackBucket *buckets, int count) {
+    FileWriter out(path);
+    if (!out.ok()) {
+        return;
+    }
+    uint64_t liveCount = 0, liveBytes = 0, allocCount = 0, allocBytes = 0;
+    for (int b = 0; b < count; b++) {
+        const StackBucket &bucket = buckets[b];
+        liveCount += bucket.liveCount;
+        liveBytes += bucket.liveBytes;
+        allocCount += bucket.allocCount;
+        allocBytes += bucket.allocBytes;
+    }
+    out.printf("heap profile: %6llu: %8llu [%6llu: %8llu] @ heap_v2/%llu\n",
+               static_cast<unsigned long long>(liveCount), static_cast<unsigned long long>(liveBytes),
+               static_cast<unsigned long long>(allocCount), static_cast<unsigned long long>(allocBytes),
+               static_cast<unsigned long long>(g_rate.load()));
+    for (int b = 0; b < count; b++) {
+        const StackBucket &bucket = buckets[b];
+        out.printf("%6llu: %8llu [%6llu: %8llu] @", static_cast<unsigned long long>(bucket.liveCount),
+                   static_cast<unsigned long long>(bucket.liveBytes),
+                   static_cast<unsigned long long>(bucket.allocCount),
+                   static_cast<unsigned long long>(bucket.allocBytes));
+        for (int i = 0; i < bucket.depth; i++) {
+            out.printf(" %p", bucket.frames[i]);
+        }
+        out.append("\n", 1);
+    }
+
+    out.printf("\nMAPPED_LIBRARIES:\n");
+    int maps = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (maps >= 0) {
+        char chunk[1024];
+        ssize_t len;
+        while ((len = read(maps, chunk, sizeof(chunk))) > 0) {
+            out.append(chunk, static_cast<size_t>(len));
+        }
+        close(maps);
+    }
+}
+
+// Estimated live bytes per stack, root first, for flamegraph.pl
+void writeFolded(const char *path, const StackBucket *buckets, int count) {
+    FileWriter out(path);
+    if (!out.ok()) {
+        return;
+    }
+    for (int b = 0; b < count; b++) {
+        const StackBucket &bucket = buckets[b];
+        if (bucket.liveCount == 0) {
+            continue;
+        }
+        for (int i = bucket.depth; i-- > 0;) {
+            char name[256];
+            foldedFrameName(bucket.frames[i], name, sizeof(name));
+            out.printf("%s%s", name, i > 0 ? ";" : "");
+        }
+        out.printf(" %llu\n", static_cast<unsigned long long>(llround(bucket.liveEstimate)));
+    }
+}
+
+void dumpSignalHandler(int signum) {
+    UNUSED(signum);
+    HeapProfiler::requestDump();
+}
+
+}  // namespace
+
+void heapProfilerOnAllocate(void *ptr, size_t size, void *caller) {
+    if (t_inProfiler) {
+        return;
+    }
+    if (!t_samplerReady) {
+        t_samplerReady = true;
+        t_bytesUntilSample = nextSampleGap();
+    }
+    t_bytesUntilSample -= static_cast<int64_t>(size);
+    if (t_bytesUntilSample > 0) {
+        return;
+    }
+
+    t_inProfiler = true;
+    recordSample(ptr, size, caller);
+    t_bytesUntilSample = nextSampleGap();
+    t_inProfiler = false;
+}
+
+void heapProfilerOnFree(void *ptr) {
+    if (g_filter[hashPointer(ptr) % HEAP_PROFILE_FILTER_SLOTS].load(std::memory_order_relaxed) == 0 ||
+        t_inProfiler) {
+        return;
+    }
+    t_inProfiler = true;
+    {
+        SpinLock lock;
+        LiveBlock *block = findLive(ptr);
+        if (block != nullptr) {
+            removeLive(block);
+        }
+    }
+    t_inProfiler = false;
+}
+
+bool heapProfilerDetach(void *ptr, HeapProfilerBlock *saved) {
+    if (g_filter[hashPointer(ptr) % HEAP_PROFILE_FILTER_SLOTS].load(std::memory_order_relaxed) == 0 ||
+        t_inProfiler) {
+        return false;
+    }
+    bool found = false;
+    t_inProfiler = true;
+    {
+        SpinLock lock;
+        LiveBlock *block = findLive(ptr);
+        if (block != nullptr) {
+            *saved = {block->ptr, block->size, block->estimate, block->bucket};
+            removeLive(block);
+            found = true;
+        }
+    }
+    t_inProfiler = false;
+    return found;
+}
+
+void heapProfilerRestore(const HeapProfilerBlock &saved) {
+    t_inProfiler = true;
+    {
+        SpinLock lock;
+        if (insertLive(saved.ptr, saved.size, saved.estimate, saved.bucket)) {
+            StackBucket &stack = g_buckets[saved.bucket];
+            stack.liveCount++;
+            stack.liveBytes += saved.size;
+            stack.liveEstimate += saved.estimate;
+        } else {
+            g_droppedSamples++;
+        }
+    }
+    t_inProfiler = false;
+}
+
+void HeapProfiler::start() {
+    const char *rate = getenv(HEAP_PROFILE_RATE_ENV);
+    if (rate != nullptr && strtoull(rate, nullptr, 10) > 0) {
+        g_rate = strtoull(rate, nullptr, 10);
+    }
+    t_samplerReady = false;  // redraw this thread's gap with the new rate
+
+    const char *prefix = getenv(HEAP_PROFILE_PREFIX_ENV);
+    if (prefix != nullptr) {
+        snprintf(g_prefix, sizeof(g_prefix), "%s", prefix);
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = dumpSignalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &action, nullptr);
+
+    LOG_INFO("Heap profiler: sampling every %llu bytes on average, dump with kill -USR2 %d",
+             static_cast<unsigned long long>(g_rate.load()), static_cast<int>(getpid()));
+}
+
+void HeapProfiler::requestDump() {
+    g_dumpRequested.store(true, std::memory_order_relaxed);
+}
+
+void HeapProfiler::poll() {
+    if (g_dumpRequested.exchange(false, std::memory_order_relaxed)) {
+        dump();
+    }
+}
+
+bool HeapProfiler::dump() {
+    char heapPath[300];
+    char foldedPath[300];
+    unsigned sequence = g_dumpSequence++;
+    snprintf(heapPath, sizeof(heapPath), "%s.%d.%04u.heap", g_prefix, static_cast<int>(getpid()), sequence);
+    snprintf(foldedPath, sizeof(foldedPath), "%s.%d.%04u.folded", g_prefix, static_cast<int>(getpid()),
+             sequence);
+
+    // Only the copy is made under g_lock: dladdr() and the file writes would
+    // stall every sampled malloc/free meanwhile, and dladdr() can wait on a
+    // thread that allocates inside dlopen()
+    t_inProfiler = true;
+    {
+        SpinLock snapshotLock(g_snapshotLock);
+        int count = 0;
+        {
+            SpinLock lock;
+            for (const auto &bucket : g_buckets) {
+                if (bucket.hash != 0) {
+                    g_snapshot[count++] = bucket;
+                }
+            }
+        }
+        writePprof(heapPath, g_snapshot, count);
+        writeFolded(foldedPath, g_snapshot, count);
+    }
+    t_inProfiler = false;
+
+    if (access(heapPath, F_OK) != 0) {
+        LOG_ERROR("Heap profiler: cannot write %s", heapPath);
+        return false;
+    }
+    LOG_INFO("Heap profile written: %s (+ .folded)", heapPath);
+    return true;
+}
+
+void HeapProfiler::logSummary() {
+    uint64_t samples = 0, liveSamples = 0, stacks = 0, dropped = 0;
+    double liveEstimate = 0.0;
+    {
+        SpinLock lock;
+        for (const auto &bucket : g_buckets) {
+            if (bucket.hash != 0) {
+                stacks++;
+                samples += bucket.allocCount;
+                liveSamples += bucket.liveCount;
+                liveEstimate += bucket.liveEstimate;
+            }
+        }
+        dropped = g_droppedSamples;
+    }
+    LOG_INFO("Heap profiler: %llu samples over %llu stacks, %llu live (~%.0f bytes), %llu dropped",
+             static_cast<unsigned long long>(samples), static_cast<unsigned long long>(stacks),
+             static_cast<unsigned long long>(liveSamples), liveEstimate,
+             static_cast<unsigned long long>(dropped));
+}
+
+#endif  // HEAP_PROFILING
@@ -8,8 +8,15 @@
  * Build modes:
  *   - Debug:   make host-debug   (includes debug symbols, DEBUG defined)
  *   - Release: make host-release (optimized, NDEBUG defined)
+ *
+ * Run with --bench[=N] to run the micro-benchmarks (include/benchmark.h)
+ * instead of the main loop, or --version to print the version and exit.
+ * Benchmark options: --bench-filter=<name|group>, --bench-reps=<n>,
+ * --bench-warmup=<n>, --bench-json=<file>, --bench-context=<key>=<value>
+ * (repeatable, stored in the JSON results).
  */
 
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -17,12 +24,36 @@
 #include <sys/utsname.h>
 #include <csignal>
 
+#include "alloc_tracker.h"
+#include "benchmark.h"
 #include "config.h"
+#include "heap_profiler.h"
 #include "logger.h"
+#include "memory_pool.h"
+#include "pipeline.h"
+#include "thread_stack.h"
 
 // Global flag for graceful shutdown
 static volatile bool g_running = true;
 
+/**
+ * @brief One acquired sample flowing through the data pipeline
+ */
+struct Sample {
+    uint32_t sequence;
+    double raw;
+    double filtered;
+};
+
+// Number of samples the acquisition stage may produce (advanced by mainLoop)
+static std::atomic<uint32_t> g_samplesDue(0);
+
+static Pipeline<Sample> g_pipeline(PIPELINE_QUEUE_CAPACITY);
+
+// Preallocated storage for messages/records and per-iteration scratch memory
+static SlabPool g_messagePool("message", MESSAGE_POOL_BLOCK_SIZE, MESSAGE_POOL_BLOCK_COUNT);
+static MonotonicArena g_tickArena("tick", TICK_ARENA_SIZE);
+
 /**
  * @brief Signal handler for graceful shutdown
  */
@@ -34,11 +65,15 @@ static void signalHandler(int signum) {
 
 /**
  * @brief Get the build mode string
- * @return "Debug" or "Release" based on compile-time defines
+ * @return "Debug", "MinSize", "RelWithDebInfo" or "Release" per compile-time defines
  */
 static const char *getBuildMode() {
 #if defined(DEBUG)
     return "Debug";
+#elif defined(MINSIZE)
+    return "MinSize";
+#elif defined(RELWITHDEBINFO)
+    return "RelWithDebInfo";
 #elif defined(NDEBUG)
     return "Release";
 #else
@@ -72,6 +107,37 @@ static const char *getArchitectureName() {
 #endif
 }
 
+/**
+ * @brief Get the board profile the binary was tuned for (make BOARD=<name>)
+ * @return Board name with its -mcpu/-mfpu/-mfloat-abi settings
+ */
+static const char *getBoardProfile() {
+#if defined(BOARD_NAME) && defined(BOARD_FPU)
+    return STRINGIFY(BOARD_NAME) " (cpu=" STRINGIFY(BOARD_CPU) ", fpu=" STRINGIFY(BOARD_FPU)
+        ", float-abi=" STRINGIFY(BOARD_FLOAT_ABI) ")";
+#elif defined(BOARD_NAME)
+    return STRINGIFY(BOARD_NAME) " (cpu=" STRINGIFY(BOARD_CPU) ")";
+#else
+    return "generic (toolchain default)";
+#endif
+}
+
+/**
+ * @brief Get the C++ runtime features the binary was compiled with (make PROFILE=...)
+ * @return "embedded (...)" without exceptions/RTTI, "standard" otherwise
+ */
+static const char *getRuntimeProfile() {
+#if !defined(__cpp_exceptions) && !defined(__GXX_RTTI)
+    return "embedded (no exceptions, no RTTI)";
+#elif !defined(__cpp_exceptions)
+    return "no exceptions";
+#elif !defined(__GXX_RTTI)
+    return "no RTTI";
+#else
+    return "standard (exceptions, RTTI)";
+#endif
+}
+
 /**
  * @brief Print build information (DEBUG-only)
  * This function demonstrates conditional compilation
@@ -83,6 +149,7 @@ static void printBuildInfo() {
     LOG_DEBUG("Compiled: %s %s", __DATE__, __TIME__);
     LOG_DEBUG("Compiler: %s", __VERSION__);
     LOG_DEBUG("C++ Standard: %ld", __cplusplus);
+    LOG_DEBUG("Board: %s", getBoardProfile());
     LOG_DEBUG("File: %s", __FILE__);
     LOG_DEBUG("================================");
 #endif
@@ -109,6 +176,20 @@ static void debugAssertDemo() {
         free(ptr);
         LOG_DEBUG("Memory freed successfully");
     }
+
+    // Same round trip through the preallocated pool and tick arena
+    Sample *pooled = g_messagePool.create<Sample>();
+    if (pooled) {
+        LOG_DEBUG("Pool allocation test: %p (%zu byte block)", static_cast<void *>(pooled),
+                  g_messagePool.blockSize());
+        g_messagePool.destroy(pooled);
+    }
+    char *scratch = static_cast<char *>(g_tickArena.allocate(100));
+    if (scratch) {
+        memset(scratch, 0, 100);
+        LOG_DEBUG("Arena allocation test: %p (%zu bytes used)", static_cast<void *>(scratch),
+                  g_tickArena.used());
+    }
 #endif
 }
 
@@ -128,6 +209,8 @@ static void printSystemInfo() {
         LOG_INFO("Machine:      %s", sysinfo.machine);
         LOG_INFO("Build Target: %s", getArchitectureName());
         LOG_INFO("Build Mode:   %s", getBuildMode());
+        LOG_INFO("Board:        %s", getBoardProfile());
+        LOG_INFO("Runtime:      %s", getRuntimeProfile());
         LOG_INFO("===========================================");
     } else {
         LOG_ERROR("uname() failed");
@@ -160,14 +243,74 @@ static void printUserInfo() {
     }
 }
 
+/**
+ * @brief Declare the acquisition -> filter -> export pipeline
+ *
+ * Stage placement defaults to the event loop and can be overridden with the
+ * PIPELINE_TOPOLOGY environment variable, e.g. "filter:thread,export:thread:64"
+ * (optional third field: worker stack size in KiB).
+ */
+static bool setupPipeline() {
+    static uint32_t nextSequence = 0;
+    static double average = 0.0;
+
+    g_pipeline.setSource("acquire", [](Sample &sample) {
+        if (nextSequence >= g_samplesDue.load(std::memory_order_acquire)) {
+            return false;
+        }
+        sample.sequence = nextSequence++;
+        sample.raw = 100.0 * sin(sample.sequence * 0.1);  // synthetic sensor
+        sample.filtered = sample.raw;
+        return true;
+    });
+
+    g_pipeline.addStage("filter", [](Sample &sample) {
+        average += PIPELINE_FILTER_ALPHA * (sample.raw - average);
+        sample.filtered = average;
+        return true;
+    });
+
+    g_pipeline.setSink("export", [](Sample &sample) {
+        LOG_DEBUG("Sample #%u raw=%.2f filtered=%.2f", sample.sequence, sample.raw, sample.filtered);
+        return true;
+    });
+
+    const char *topology = getenv(PIPELINE_TOPOLOGY_ENV);
+    if (topology != nullptr) {
+        LOG_INFO("Pipeline topology override: %s", topology);
+        g_pipeline.configure(topology);
+    }
+    return g_pipeline.start();
+}
+
+/**
+ * @brief Per-period work of the main loop (also timed by the loop/tick benchmark)
+ */
+static void runTick() {
+    // Scratch memory from the previous iteration is released in one step
+    g_tickArena.reset();
+
+    // Write a heap profile if one was requested with SIGUSR2
+    HeapProfiler::poll();
+
+    // Release one sample into the pipeline and pump loop-mode stages
+    g_samplesDue.fetch_add(1, std::memory_order_release);
+    g_pipeline.poll();
+}
+
 /**
  * @brief Main application loop
  */
 static void mainLoop() {
     LOG_INFO("Starting main loop (Ctrl+C to exit)...");
 
+    // From here on every heap allocation is a steady-state violation
+    AllocTracker::setPhase(AllocPhase::PHASE_STEADY);
+
     int counter = 0;
     while (g_running) {
+        runTick();
+
         // In release builds, only show every 10th iteration to reduce output
 #ifdef DEBUG
         LOG_DEBUG("Counter: %d", counter);
@@ -188,12 +331,61 @@ static void mainLoop() {
         usleep(LOOP_DELAY_US);
     }
 
+    AllocTracker::setPhase(AllocPhase::PHASE_SHUTDOWN);
+
     LOG_INFO("Main loop exited after %d iterations", counter);
 }
 
+/**
+ * @brief Pipeline cost of one sample in the default (loop) topology
+ */
+static void benchPipelineSample(BenchState &state) {
+    while (state.next()) {
+        g_samplesDue.fetch_add(1, std::memory_order_release);
+        g_pipeline.poll();
+    }
+}
+BENCHMARK("pipeline/sample", benchPipelineSample, 100000);
+
+/**
+ * @brief Scheduling work mainLoop does every period, excluding logging and sleep
+ */
+static void benchLoopTick(BenchState &state) {
+    while (state.next()) {
+        runTick();
+    }
+}
+BENCHMARK("loop/tick", benchLoopTick, 100000);
+
 int main(int argc, char *argv[]) {
-    UNUSED(argc);
-    UNUSED(argv);
+    bool bench = false;
+    BenchOptions benchOptions = {0, BENCH_DEFAULT_REPETITIONS, BENCH_DEFAULT_WARMUP, nullptr,
+                                 nullptr, getArchitectureName(), getBuildMode(),
+                                 getBoardProfile(), getRuntimeProfile(), {}, 0};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        } else if (strncmp(argv[i], "--bench=", 8) == 0) {
+            bench = true;
+            benchOptions.iterations = strtol(argv[i] + 8, nullptr, 10);
+        } else if (strncmp(argv[i], "--bench-filter=", 15) == 0) {
+            benchOptions.filter = argv[i] + 15;
+        } else if (strncmp(argv[i], "--bench-reps=", 13) == 0) {
+            benchOptions.repetitions = atoi(argv[i] + 13);
+        } else if (strncmp(argv[i], "--bench-warmup=", 15) == 0) {
+            benchOptions.warmup = atoi(argv[i] + 15);
+        } else if (strncmp(argv[i], "--bench-json=", 13) == 0) {
+            benchOptions.jsonPath = argv[i] + 13;
+        } else if (strncmp(argv[i], "--bench-context=", 16) == 0) {
+            if (benchOptions.contextCount < BENCH_MAX_CONTEXT) {
+                benchOptions.context[benchOptions.contextCount++] = argv[i] + 16;
+            }
+        } else if (strcmp(argv[i], "--version") == 0) {
+            // Also used to time process startup (loader + static init)
+            printf("%s v%s [%s]\n", PROJECT_NAME, PROJECT_VERSION_STRING, getBuildMode());
+            return EXIT_SUCCESS;
+        }
+    }
 
     // Setup signal handlers for graceful shutdown
     signal(SIGINT, signalHandler);
@@ -210,6 +402,9 @@ int main(int argc, char *argv[]) {
 
     LOG_INFO("Application starting...");
 
+    // Sampling heap profiler (HEAP_PROFILE=1 builds only)
+    HeapProfiler::start();
+
     // Show build information (debug only)
     printBuildInfo();
 
@@ -220,9 +415,30 @@ int main(int argc, char *argv[]) {
     printSystemInfo();
     printUserInfo();
 
-    // Run main application loop
-    mainLoop();
+    if (!setupPipeline()) {
+        LOG_FATAL("Pipeline setup failed");
+        return EXIT_FAILURE;
+    }
+
+    // Run main application loop, or the benchmarks
+    int status = EXIT_SUCCESS;
+    if (bench) {
+        if (Benchmarks::run(benchOptions) <= 0) {
+            status = EXIT_FAILURE;
+        }
+    } else {
+        mainLoop();
+    }
+
+    g_pipeline.stop();
+    g_pipeline.logMetrics();
+    g_messagePool.logStats();
+    g_tickArena.logStats();
+    ThreadStacks::logReport();
+    AllocTracker::report();
+    HeapProfiler::dump();
+    HeapProfiler::logSummary();
 
     LOG_INFO("Application terminated gracefully");
-    return EXIT_SUCCESS;
+    return status;
 }
@@ -0,0 +1,168 @@
+/**
+ * @file malloc_hooks.cpp
+ * @brief malloc-family interposition shared by the allocation diagnostics
+ *
+ * Compiled in when ALLOC_TRACKING (ALLOC_TRACK=1) or HEAP_PROFILING
+ * (HEAP_PROFILE=1) is defined. The wrappers forward to glibc's __libc_*
+ * entry points, so this file is glibc-specific. operator new/delete are
+ * covered because libstdc++ implements them on top of malloc/free.
+ */
+
+#include "malloc_hooks.h"
+
+#ifdef MALLOC_HOOKS
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+#include <malloc.h>
+
+#ifndef __GLIBC__
+#error "ALLOC_TRACK/HEAP_PROFILE forward to glibc's __libc_* allocator and need a glibc toolchain"
+#endif
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace {
+
+void onAllocate(void *ptr, size_t size, void *caller) {
+    if (ptr == nullptr) {
+        return;
+    }
+#ifdef ALLOC_TRACKING
+    allocTrackerOnAllocate(size, malloc_usable_size(ptr), caller);
+#endif
+#ifdef HEAP_PROFILING
+    heapProfilerOnAllocate(ptr, size, caller);
+#endif
+}
+
+// Called before the block is released, while its usable size is still readable
+void onFree(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+#ifdef ALLOC_TRACKING
+    allocTrackerOnFree(malloc_usable_size(ptr));
+#endif
+#ifdef HEAP_PROFILING
+    heapProfilerOnFree(ptr);
+#endif
+}
+
+}  // namespace
+
+void mallocHooksFormatAddress(const void *address, char *buffer, size_t size) {
+    Dl_info info;
+    if (dladdr(address, &info) != 0 && info.dli_fname != nullptr) {
+        const char *module = strrchr(info.dli_fname, '/');
+        module = module ? module + 1 : info.dli_fname;
+        uintptr_t offset = reinterpret_cast<uintptr_t>(address) -
+                           reinterpret_cast<uintptr_t>(info.dli_fbase);
+        if (info.dli_sname != nullptr) {
+            snprintf(buffer, size, "%s (%s+0x%lx)", info.dli_sname, module,
+                     static_cast<unsigned long>(offset));
+        } else {
+            snprintf(buffer, size, "%s+0x%lx", module, static_cast<unsigned long>(offset));
+        }
+    } else {
+        snprintf(buffer, size, "%p", address);
+    }
+}
+
+// ============================================================================
+// Interposed allocator entry points
+// ============================================================================
+
+extern "C" {
+
+void *malloc(size_t size) {
+    void *ptr = __libc_malloc(size);
+    onAllocate(ptr, size, __builtin_return_address(0));
+    return ptr;
+}
+
+void *calloc(size_t count, size_t size) {
+    void *ptr = __libc_calloc(count, size);
+    onAllocate(ptr, count * size, __builtin_return_address(0));
+    return ptr;
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (ptr == nullptr) {
+        void *fresh = __libc_malloc(size);
+        onAllocate(fresh, size, __builtin_return_address(0));
+        return fresh;
+    }
+    if (size == 0) {
+        free(ptr);
+        return nullptr;
+    }
+
+    // A successful realloc frees the old block (even when it returns the same
+    // address) and allocates the result. The profiler forgets the old block
+    // before realloc can release it: afterwards another thread may already
+    // have been handed, and sampled, the same address. If realloc fails the
+    // old block is still live and goes back.
+    size_t oldUsable = malloc_usable_size(ptr);
+#ifdef HEAP_PROFILING
+    HeapProfilerBlock sampled;
+    bool wasSampled = heapProfilerDetach(ptr, &sampled);
+#endif
+    void *result = __libc_realloc(ptr, size);
+    if (result != nullptr) {
+#ifdef ALLOC_TRACKING
+        allocTrackerOnFree(oldUsable);
+#endif
+        onAllocate(result, size, __builtin_return_address(0));
+    }
+#ifdef HEAP_PROFILING
+    else if (wasSampled) {
+        heapProfilerRestore(sampled);
+    }
+#endif
+    (void)oldUsable;
+    return result;
+}
+
+void free(void *ptr) {
+    onFree(ptr);
+    __libc_free(ptr);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    void *ptr = __libc_memalign(alignment, size);
+    onAllocate(ptr, size, __builtin_return_address(0));
+    return ptr;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    void *ptr = __libc_memalign(alignment, size);
+    onAllocate(ptr, size, __builtin_return_address(0));
+    return ptr;
+}
+
+int posix_memalign(void **result, size_t alignment, size_t size) {
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *ptr = __libc_memalign(alignment, size);
+    if (ptr == nullptr) {
+        return ENOMEM;
+    }
+    onAllocate(ptr, size, __builtin_return_address(0));
+    *result = ptr;
+    return 0;
+}
+
+}  // extern "C"
+
+#endif  // MALLOC_HOOKS
@@ -0,0 +1,243 @@
+/**
+ * @file thread_stack.cpp
+ * @brief StackThread implementation and the thread stack registry
+ */
+
+#include "thread_stack.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "logger.h"
+
+namespace {
+
+struct RegistryEntry {
+    bool used;
+    ThreadStackInfo info;
+    const StackThread *thread;  // non-null while running
+};
+
+std::mutex g_registryMutex;
+RegistryEntry g_registry[THREAD_STACK_MAX_THREADS];
+int g_nextSlot = 0;
+
+size_t pageSize() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+#ifndef THREAD_STACK_PAINT
+// Lowest touched address found by scanning page residency from the bottom up
+size_t residentHighWater(const unsigned char *stack, size_t size) {
+    const size_t page = pageSize();
+    unsigned char residency[256];
+    for (size_t offset = 0; offset < size;) {
+        size_t pages = (size - offset) / page;
+        if (pages > sizeof(residency)) {
+            pages = sizeof(residency);
+        }
+        if (mincore(const_cast<unsigned char *>(stack + offset), pages * page, residency) != 0) {
+            return 0;
+        }
+        for (size_t i = 0; i < pages; i++) {
+            if (residency[i] & 1) {
+                return size - (offset + i * page);
+            }
+        }
+        offset += pages * page;
+    }
+    return 0;
+}
+#else
+// Lowest word that no longer holds the paint pattern
+size_t paintedHighWater(const unsigned char *stack, size_t size) {
+    const uint32_t *words = reinterpret_cast<const uint32_t *>(stack);
+    size_t count = size / sizeof(uint32_t);
+    for (size_t i = 0; i < count; i++) {
+        if (words[i] != THREAD_STACK_PAINT_WORD) {
+            return size - i * sizeof(uint32_t);
+        }
+    }
+    return 0;
+}
+#endif
+
+// VmStk from /proc/self/status (main thread stack, grows on demand)
+size_t mainStackBytes() {
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status == nullptr) {
+        return 0;
+    }
+    char line[128];
+    size_t kib = 0;
+    while (fgets(line, sizeof(line), status) != nullptr) {
+        if (strncmp(line, "VmStk:", 6) == 0) {
+            kib = strtoul(line + 6, nullptr, 10);
+            break;
+        }
+    }
+    fclose(status);
+    return kib * 1024;
+}
+
+}  // namespace
+
+StackThread::StackThread()
+    : thread_(), started_(false), mapping_(nullptr), mappingSize_(0), stackSize_(0), finalUsed_(0),
+      slot_(-1) {}
+
+StackThread::~StackThread() {
+    join();
+}
+
+bool StackThread::start(const char *name, size_t stackSize, std::function<void()> body) {
+    if (started_) {
+        return false;
+    }
+
+    const size_t page = pageSize();
+    if (stackSize < static_cast<size_t>(PTHREAD_STACK_MIN)) {
+        stackSize = PTHREAD_STACK_MIN;
+    }
+    stackSize_ = (stackSize + page - 1) / page * page;
+    mappingSize_ = stackSize_ + page;
+
+    void *mapping = mmap(nullptr, mappingSize_, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("StackThread %s: cannot map %zu byte stack", name, stackSize_);
+        return false;
+    }
+    mapping_ = static_cast<unsigned char *>(mapping);
+    mprotect(mapping_, page, PROT_NONE);  // guard page below the stack
+    unsigned char *stack = mapping_ + page;
+
+#ifdef THREAD_STACK_PAINT
+    uint32_t *words = reinterpret_cast<uint32_t *>(stack);
+    for (size_t i = 0; i < stackSize_ / sizeof(uint32_t); i++) {
+        words[i] = THREAD_STACK_PAINT_WORD;
+    }
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        slot_ = g_nextSlot;
+        g_nextSlot = (g_nextSlot + 1) % THREAD_STACK_MAX_THREADS;
+        RegistryEntry &entry = g_registry[slot_];
+        entry.used = true;
+        snprintf(entry.info.name, sizeof(entry.info.name), "%s", name);
+        entry.info.size = stackSize_;
+        entry.info.used = 0;
+        entry.info.running = true;
+        entry.thread = this;
+    }
+
+    body_ = body;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, stackSize_);
+    int rc = pthread_create(&thread_, &attr, &StackThread::trampoline, this);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        LOG_ERROR("StackThread %s: pthread_create() failed: %s", name, strerror(rc));
+        munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        g_registry[slot_].used = false;
+        g_registry[slot_].thread = nullptr;
+        return false;
+    }
+
+    pthread_setname_np(thread_, g_registry[slot_].info.name);
+    started_ = true;
+    return true;
+}
+
+void StackThread::join() {
+    if (!started_) {
+        return;
+    }
+    pthread_join(thread_, nullptr);
+    started_ = false;
+    finalUsed_ = stackUsed();
+
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        RegistryEntry &entry = g_registry[slot_];
+        if (entry.thread == this) {
+            entry.info.used = finalUsed_;
+            entry.info.running = false;
+            entry.thread = nullptr;
+        }
+    }
+
+    munmap(mapping_, mappingSize_);
+    mapping_ = nullptr;
+}
+
+size_t StackThread::stackUsed() const {
+    if (mapping_ == nullptr) {
+        return finalUsed_;
+    }
+    const unsigned char *stack = mapping_ + (mappingSize_ - stackSize_);
+#ifdef THREAD_STACK_PAINT
+    return paintedHighWater(stack, stackSize_);
+#else
+    return residentHighWater(stack, stackSize_);
+#endif
+}
+
+void *StackThread::trampoline(void *self) {
+    static_cast<StackThread *>(self)->body_();
+    return nullptr;
+}
+
+size_t ThreadStacks::defaultSize() {
+    const char *value = getenv(THREAD_STACK_SIZE_ENV);
+    if (value != nullptr && strtoul(value, nullptr, 10) > 0) {
+        return strtoul(value, nullptr, 10) * 1024;
+    }
+    return THREAD_STACK_SIZE_DEFAULT;
+}
+
+bool ThreadStacks::info(int index, ThreadStackInfo *out) {
+    if (index < 0 || index >= THREAD_STACK_MAX_THREADS) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    const RegistryEntry &entry = g_registry[index];
+    if (!entry.used) {
+        return false;
+    }
+    *out = entry.info;
+    if (entry.thread != nullptr) {
+        out->used = entry.thread->stackUsed();
+    }
+    return true;
+}
+
+void ThreadStacks::logReport() {
+#ifdef THREAD_STACK_PAINT
+    LOG_INFO("Thread stacks (painted high-water marks):");
+#else
+    LOG_INFO("Thread stacks (resident-page high-water marks):");
+#endif
+    LOG_INFO("  %-15s %8s %8s %5s", "thread", "size KiB", "peak KiB", "use%");
+    LOG_INFO("  %-15s %8s %8zu %5s", "main (VmStk)", "-", mainStackBytes() / 1024, "-");
+    for (int i = 0; i < THREAD_STACK_MAX_THREADS; i++) {
+        ThreadStackInfo info;
+        if (!ThreadStacks::info(i, &info)) {
+            continue;
+        }
+        LOG_INFO("  %-15s %8zu %8zu %4zu%%%s", info.name, info.size / 1024, (info.used + 1023) / 1024,
+                 info.size ? info.used * 100 / info.size : static_cast<size_t>(0),
+                 info.running ? " (running)" : "");
+    }
+}